@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "coefficient_cache.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+using fir_window::CoefficientCache;
+using fir_window::DesignSpec;
+using fir_window::Tolerance;
+using fir_window::ToleranceFit;
+
+constexpr char MAGIC[8] = {'F', 'I', 'R', 'W', 'C', 'O', 'E', 'F'};
+// kind of a fit outcome entry, after the kinds of coefficient sets
+constexpr uint32_t FIT_KIND = CoefficientCache::QUADRATURE + 1;
+
+// Start of every cache file. Everything before count identifies the
+// coefficient set; no padding, so the bytes
+// can be hashed and compared directly.
+struct cache_header_t
+{
+  char magic[8];
+  uint32_t design_version;
+  uint32_t kind;
+  int64_t window_shape;
+  int64_t filter_type;
+  uint64_t num_taps;
+  double lambda1;
+  double lambda2;
+  double Kalpha;
+  double Calpha;
+  int64_t phase_response;
+  int64_t method;
+  double transition;
+  double stopband_weight;
+  uint64_t count;  // doubles following the header
+  uint64_t checksum;  // of those doubles
+};
+
+constexpr size_t IDENTITY_BYTES = offsetof(cache_header_t, count);
+
+// The whole of a fit outcome file. Everything before num_taps identifies
+// the fit: the base spec with its tap count zeroed, which the search
+// ignores, then the tolerance and the tap limit.
+struct fit_entry_t
+{
+  cache_header_t base;  // kind FIT_KIND, count and checksum 0
+  double passband_ripple_db;
+  double stopband_attenuation_db;
+  uint64_t max_taps;
+  uint64_t num_taps;
+  double Kalpha;
+  double Calpha;
+  double stopband_weight;
+  uint64_t met;
+  double achieved_passband_ripple_db;
+  double achieved_stopband_attenuation_db;
+  uint64_t checksum;  // of the outcome from num_taps on
+};
+
+constexpr size_t FIT_IDENTITY_BYTES = offsetof(fit_entry_t, num_taps);
+constexpr size_t FIT_OUTCOME_BYTES =
+    offsetof(fit_entry_t, checksum) - FIT_IDENTITY_BYTES;
+
+// 64-bit FNV-1a
+uint64_t fnv1a(const void* data, size_t bytes)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  const auto* p = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < bytes; i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+cache_header_t identify(const DesignSpec& spec, uint32_t kind)
+{
+  cache_header_t header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.design_version = fir_window::DESIGN_VERSION;
+  header.kind = kind;
+  header.window_shape = spec.window_shape;
+  header.filter_type = spec.filter_type;
+  header.num_taps = spec.num_taps;
+  header.lambda1 = spec.lambda1;
+  header.lambda2 = spec.lambda2;
+  header.Kalpha = spec.Kalpha;
+  header.Calpha = spec.Calpha;
+  header.phase_response = spec.phase_response;
+  header.method = spec.method;
+  header.transition = spec.transition;
+  header.stopband_weight = spec.stopband_weight;
+  return header;
+}
+
+fit_entry_t identify_fit(const DesignSpec& base,
+                         const Tolerance& tolerance,
+                         size_t max_taps)
+{
+  fit_entry_t entry;
+  std::memset(&entry, 0, sizeof(entry));
+  DesignSpec key = base;
+  key.num_taps = 0;
+  entry.base = identify(key, FIT_KIND);
+  entry.passband_ripple_db = tolerance.passband_ripple_db;
+  entry.stopband_attenuation_db = tolerance.stopband_attenuation_db;
+  entry.max_taps = max_taps;
+  return entry;
+}
+
+// "<hash>.fir" in root, named after the identifying bytes
+std::filesystem::path entry_path(const std::filesystem::path& root,
+                                 const void* identity,
+                                 size_t bytes)
+{
+  char name[24];
+  std::snprintf(name,
+                sizeof(name),
+                "%016llx.fir",
+                static_cast<unsigned long long>(fnv1a(identity, bytes)));
+  return root / name;
+}
+
+// pread until bytes have arrived, false on an error or end of file
+bool read_at(int fd, void* data, size_t bytes, off_t offset)
+{
+  auto* p = static_cast<char*>(data);
+  while (bytes > 0) {
+    const ssize_t got = pread(fd, p, bytes, offset);
+    if (got <= 0) {
+      return false;
+    }
+    p += got;
+    bytes -= static_cast<size_t>(got);
+    offset += got;
+  }
+  return true;
+}
+
+// Writes head and payload to a name unique per process and thread, then
+// renames it over target, so readers never see a partial file
+bool write_entry(const std::filesystem::path& target,
+                 const void* head,
+                 size_t head_bytes,
+                 const void* payload,
+                 size_t payload_bytes)
+{
+  std::error_code error;
+  std::filesystem::create_directories(target.parent_path(), error);
+  if (error) {
+    return false;
+  }
+  const std::filesystem::path temporary = target.string() + ".tmp."
+      + std::to_string(getpid()) + "."
+      + std::to_string(
+          std::hash<std::thread::id> {}(std::this_thread::get_id()));
+  std::FILE* file = std::fopen(temporary.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool written = std::fwrite(head, head_bytes, 1, file) == 1
+      && (payload_bytes == 0
+          || std::fwrite(payload, payload_bytes, 1, file) == 1);
+  const bool closed = std::fclose(file) == 0;
+  if (!written || !closed) {
+    std::filesystem::remove(temporary, error);
+    return false;
+  }
+  std::filesystem::rename(temporary, target, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+fir_window::CoefficientCache::CoefficientCache(std::filesystem::path directory,
+                                               uint64_t max_bytes)
+    : root(std::move(directory))
+    , limit(max_bytes)
+{
+}
+
+std::filesystem::path fir_window::CoefficientCache::defaultDirectory()
+{
+  if (const char* dir = std::getenv("FIR_WINDOW_CACHE_DIR")) {
+    return dir;
+  }
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return std::filesystem::path(xdg) / "rtxi" / "fir-window";
+  }
+  if (const char* home = std::getenv("HOME"); home && *home) {
+    return std::filesystem::path(home) / ".cache" / "rtxi" / "fir-window";
+  }
+  return {};
+}
+
+std::filesystem::path fir_window::CoefficientCache::entry(
+    const DesignSpec& spec, kind_t kind) const
+{
+  const cache_header_t header = identify(spec, kind);
+  return entry_path(root, &header, IDENTITY_BYTES);
+}
+
+std::filesystem::path fir_window::CoefficientCache::fitEntry(
+    const DesignSpec& base, const Tolerance& tolerance, size_t max_taps) const
+{
+  const fit_entry_t identity = identify_fit(base, tolerance, max_taps);
+  return entry_path(root, &identity, FIT_IDENTITY_BYTES);
+}
+
+std::vector<double> fir_window::CoefficientCache::design(const DesignSpec& spec,
+                                                         kind_t kind)
+{
+  std::vector<double> h;
+  if (load(spec, kind, h)) {
+    hit_count++;
+    return h;
+  }
+  miss_count++;
+  h = kind == QUADRATURE ? design_quadrature(spec) : design_filter(spec);
+  store(spec, kind, h);
+  return h;
+}
+
+bool fir_window::CoefficientCache::load(const DesignSpec& spec,
+                                        kind_t kind,
+                                        std::vector<double>& h) const
+{
+  if (root.empty()) {
+    return false;
+  }
+  const int fd = ::open(entry(spec, kind).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0
+      || static_cast<size_t>(info.st_size) < sizeof(cache_header_t))
+  {
+    ::close(fd);
+    return false;
+  }
+  const auto length = static_cast<size_t>(info.st_size);
+  const cache_header_t expected = identify(spec, kind);
+  cache_header_t header;
+  const size_t payload_bytes = length - sizeof(cache_header_t);
+  bool valid = read_at(fd, &header, sizeof(header), 0)
+      && std::memcmp(&header, &expected, IDENTITY_BYTES) == 0
+      && header.count == spec.num_taps
+      && payload_bytes == header.count * sizeof(double);
+  if (valid) {
+    // straight into h, with no mapping or intermediate copy
+    h.resize(header.count);
+    valid = read_at(fd, h.data(), payload_bytes, sizeof(cache_header_t))
+        && fnv1a(h.data(), payload_bytes) == header.checksum;
+  }
+  ::close(fd);
+  if (valid) {
+    // the modification time doubles as the last use for trim()
+    utimensat(AT_FDCWD, entry(spec, kind).c_str(), nullptr, 0);
+  }
+  return valid;
+}
+
+bool fir_window::CoefficientCache::store(const DesignSpec& spec,
+                                         kind_t kind,
+                                         const std::vector<double>& h) const
+{
+  if (root.empty()) {
+    return false;
+  }
+  cache_header_t header = identify(spec, kind);
+  header.count = h.size();
+  header.checksum = fnv1a(h.data(), h.size() * sizeof(double));
+  if (!write_entry(entry(spec, kind),
+                   &header,
+                   sizeof(header),
+                   h.data(),
+                   h.size() * sizeof(double)))
+  {
+    return false;
+  }
+  trim();
+  return true;
+}
+
+fir_window::ToleranceFit fir_window::CoefficientCache::fit(
+    const DesignSpec& base, const Tolerance& tolerance, size_t max_taps)
+{
+  ToleranceFit found;
+  if (loadFit(base, tolerance, max_taps, found)) {
+    hit_count++;
+    return found;
+  }
+  miss_count++;
+  found = fit_to_tolerance(base, tolerance, max_taps);
+  storeFit(base, tolerance, max_taps, found);
+  return found;
+}
+
+bool fir_window::CoefficientCache::loadFit(const DesignSpec& base,
+                                           const Tolerance& tolerance,
+                                           size_t max_taps,
+                                           ToleranceFit& fit) const
+{
+  if (root.empty()) {
+    return false;
+  }
+  const std::filesystem::path path = fitEntry(base, tolerance, max_taps);
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  fit_entry_t stored;
+  const bool read = fstat(fd, &info) == 0
+      && static_cast<size_t>(info.st_size) == sizeof(stored)
+      && read_at(fd, &stored, sizeof(stored), 0);
+  ::close(fd);
+  const fit_entry_t expected = identify_fit(base, tolerance, max_taps);
+  const auto* outcome =
+      reinterpret_cast<const unsigned char*>(&stored) + FIT_IDENTITY_BYTES;
+  if (!read || std::memcmp(&stored, &expected, FIT_IDENTITY_BYTES) != 0
+      || fnv1a(outcome, FIT_OUTCOME_BYTES) != stored.checksum)
+  {
+    return false;
+  }
+  fit.spec = base;
+  fit.spec.num_taps = stored.num_taps;
+  fit.spec.Kalpha = stored.Kalpha;
+  fit.spec.Calpha = stored.Calpha;
+  fit.spec.stopband_weight = stored.stopband_weight;
+  fit.met = stored.met != 0;
+  fit.achieved.passband_ripple_db = stored.achieved_passband_ripple_db;
+  fit.achieved.stopband_attenuation_db =
+      stored.achieved_stopband_attenuation_db;
+  utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+  return true;
+}
+
+bool fir_window::CoefficientCache::storeFit(const DesignSpec& base,
+                                            const Tolerance& tolerance,
+                                            size_t max_taps,
+                                            const ToleranceFit& fit) const
+{
+  if (root.empty()) {
+    return false;
+  }
+  fit_entry_t stored = identify_fit(base, tolerance, max_taps);
+  stored.num_taps = fit.spec.num_taps;
+  stored.Kalpha = fit.spec.Kalpha;
+  stored.Calpha = fit.spec.Calpha;
+  stored.stopband_weight = fit.spec.stopband_weight;
+  stored.met = fit.met ? 1 : 0;
+  stored.achieved_passband_ripple_db = fit.achieved.passband_ripple_db;
+  stored.achieved_stopband_attenuation_db =
+      fit.achieved.stopband_attenuation_db;
+  stored.checksum = fnv1a(
+      reinterpret_cast<const unsigned char*>(&stored) + FIT_IDENTITY_BYTES,
+      FIT_OUTCOME_BYTES);
+  if (!write_entry(fitEntry(base, tolerance, max_taps),
+                   &stored,
+                   sizeof(stored),
+                   nullptr,
+                   0))
+  {
+    return false;
+  }
+  trim();
+  return true;
+}
+
+void fir_window::CoefficientCache::trim() const
+{
+  if (root.empty()) {
+    return;
+  }
+  struct file_t
+  {
+    std::filesystem::file_time_type used;
+    uint64_t bytes;
+    std::filesystem::path path;
+  };
+  std::vector<file_t> files;
+  uint64_t total = 0;
+  std::error_code error;
+  for (const auto& item : std::filesystem::directory_iterator(root, error)) {
+    if (item.path().extension() != ".fir") {
+      continue;
+    }
+    file_t file {item.last_write_time(error), item.file_size(error), item};
+    if (error) {
+      // removed by another instance while listing
+      continue;
+    }
+    total += file.bytes;
+    files.push_back(std::move(file));
+  }
+  if (total <= limit) {
+    return;
+  }
+  std::sort(files.begin(),
+            files.end(),
+            [](const file_t& a, const file_t& b) { return a.used < b.used; });
+  for (const auto& file : files) {
+    if (total <= limit) {
+      break;
+    }
+    std::filesystem::remove(file.path, error);
+    total -= file.bytes;
+  }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "design.hpp"
+#include "tolerance_design.hpp"
+
+namespace fir_window
+{
+
+// Content-addressed on-disk store of designed coefficients.
+//
+// Each coefficient set lives in its own file named after a 64-bit hash of
+// the full DesignSpec, the kind of design and DESIGN_VERSION. A lookup
+// reads the file and only accepts it if the stored spec matches field for
+// field and the payload checksum is intact; anything else is a miss and
+// the set is designed again and rewritten. The outcome of a tolerance fit
+// (tap count, shape parameters, whether the spec was met) is kept the same
+// way, keyed by the base spec, the tolerance and the tap limit, so
+// re-applying a spec skips the search as well as the design. Files are
+// written to a temporary name and renamed into place, so concurrent
+// instances never see a partial file. Every failure degrades to designing
+// without the cache.
+//
+// The directory is bounded: a hit refreshes the file's modification time,
+// and after every store the least recently used entries are removed until
+// the .fir files take at most max_bytes. Every call does file I/O, so the
+// cache is for design time, never for the real-time thread. design() and
+// fit() may be called from several threads at once.
+class CoefficientCache
+{
+public:
+  enum kind_t : uint32_t
+  {
+    FILTER = 0,  // design_filter()
+    QUADRATURE  // design_quadrature()
+  };
+
+  static constexpr uint64_t DEFAULT_MAX_BYTES = uint64_t {64} << 20;
+
+  // an empty directory disables the cache
+  explicit CoefficientCache(std::filesystem::path directory = {},
+                            uint64_t max_bytes = DEFAULT_MAX_BYTES);
+
+  // cached or freshly designed coefficients of the given kind
+  std::vector<double> design(const DesignSpec& spec, kind_t kind = FILTER);
+
+  // reads a cached set into h, false on a miss or a damaged file
+  bool load(const DesignSpec& spec, kind_t kind, std::vector<double>& h) const;
+  // best effort, false if the file could not be written
+  bool store(const DesignSpec& spec,
+             kind_t kind,
+             const std::vector<double>& h) const;
+
+  // cached or freshly searched fit_to_tolerance(base, tolerance, max_taps)
+  ToleranceFit fit(const DesignSpec& base,
+                   const Tolerance& tolerance,
+                   size_t max_taps);
+
+  // reads a cached fit outcome into fit, false on a miss or a damaged file
+  bool loadFit(const DesignSpec& base,
+               const Tolerance& tolerance,
+               size_t max_taps,
+               ToleranceFit& fit) const;
+  // best effort, false if the file could not be written
+  bool storeFit(const DesignSpec& base,
+                const Tolerance& tolerance,
+                size_t max_taps,
+                const ToleranceFit& fit) const;
+
+  // removes the least recently used entries beyond max_bytes
+  void trim() const;
+
+  // file that holds (or would hold) the given set
+  std::filesystem::path entry(const DesignSpec& spec, kind_t kind) const;
+  // file that holds (or would hold) the given fit outcome
+  std::filesystem::path fitEntry(const DesignSpec& base,
+                                 const Tolerance& tolerance,
+                                 size_t max_taps) const;
+
+  const std::filesystem::path& directory() const { return root; }
+  uint64_t hits() const { return hit_count.load(); }
+  uint64_t misses() const { return miss_count.load(); }
+
+  // $FIR_WINDOW_CACHE_DIR, else $XDG_CACHE_HOME/rtxi/fir-window, else
+  // ~/.cache/rtxi/fir-window, else empty
+  static std::filesystem::path defaultDirectory();
+
+private:
+  std::filesystem::path root;
+  uint64_t limit;
+  std::atomic<uint64_t> hit_count {0};
+  std::atomic<uint64_t> miss_count {0};
+};
+
+}  // namespace fir_window
@@ -0,0 +1,109 @@
+#include <cstring>
+
+#include "coefficient_registry.hpp"
+
+namespace
+{
+
+// 64-bit FNV-1a
+uint64_t fnv1a(const void* data, size_t bytes)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  const auto* p = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < bytes; i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+fir_window::CoefficientRegistry& fir_window::CoefficientRegistry::global()
+{
+  static CoefficientRegistry registry;
+  return registry;
+}
+
+fir_window::CoefficientRegistry::~CoefficientRegistry()
+{
+  collect();
+}
+
+fir_window::SharedCoefficients fir_window::CoefficientRegistry::publish(
+    std::span<const double> values)
+{
+  const size_t bytes = values.size() * sizeof(double);
+  const uint64_t hash = fnv1a(values.data(), bytes);
+  const std::scoped_lock lock(mutex);
+  collectLocked();
+  auto [first, last] = entries.equal_range(hash);
+  for (auto entry = first; entry != last; ++entry) {
+    // expired entries are retired and wait for the next collect()
+    SharedCoefficients block = entry->second.weak.lock();
+    if (block && block->size() == values.size()
+        && std::memcmp(block->data(), values.data(), bytes) == 0)
+    {
+      return block;
+    }
+  }
+
+  SharedCoefficients block(new CoefficientBlock(values, hash),
+                           [this](const CoefficientBlock* retired)
+                           { retire(retired); });
+  entries.emplace(hash, entry_t {block.get(), block});
+  return block;
+}
+
+// Runs wherever the last reference goes, possibly on the real-time
+// thread: a lock-free push, nothing else.
+void fir_window::CoefficientRegistry::retire(const CoefficientBlock* block)
+{
+  block->next_retired = retired.load(std::memory_order_relaxed);
+  while (!retired.compare_exchange_weak(block->next_retired,
+                                        block,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed))
+  {
+  }
+}
+
+void fir_window::CoefficientRegistry::collect()
+{
+  const std::scoped_lock lock(mutex);
+  collectLocked();
+}
+
+void fir_window::CoefficientRegistry::collectLocked()
+{
+  const CoefficientBlock* block =
+      retired.exchange(nullptr, std::memory_order_acquire);
+  while (block != nullptr) {
+    const CoefficientBlock* next = block->next_retired;
+    auto [first, last] = entries.equal_range(block->hash());
+    for (auto entry = first; entry != last; ++entry) {
+      if (entry->second.block == block) {
+        entries.erase(entry);
+        break;
+      }
+    }
+    delete block;
+    block = next;
+  }
+}
+
+fir_window::CoefficientRegistry::Stats fir_window::CoefficientRegistry::stats()
+{
+  Stats stats {};
+  const std::scoped_lock lock(mutex);
+  collectLocked();
+  for (const auto& [hash, entry] : entries) {
+    const long users = entry.weak.use_count();
+    if (users > 0) {
+      stats.blocks++;
+      stats.users += static_cast<size_t>(users);
+      stats.bytes += entry.block->size() * sizeof(double);
+    }
+  }
+  return stats;
+}
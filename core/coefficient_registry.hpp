@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// Read-only coefficients handed out by the CoefficientRegistry. The values
+// sit in their own locked, cache line aligned rt_vector.
+class CoefficientBlock
+{
+public:
+  explicit CoefficientBlock(std::span<const double> values, uint64_t hash)
+      : values(values.begin(), values.end())
+      , key(hash)
+  {
+  }
+
+  const double* data() const { return values.data(); }
+  size_t size() const { return values.size(); }
+  uint64_t hash() const { return key; }
+
+private:
+  friend class CoefficientRegistry;
+
+  rt_vector<double> values;
+  uint64_t key;
+  // link in the registry's list of blocks waiting to be freed
+  mutable const CoefficientBlock* next_retired = nullptr;
+};
+
+using SharedCoefficients = std::shared_ptr<const CoefficientBlock>;
+
+// Process-wide table of coefficient blocks keyed by their contents, so
+// every filter of every instance that runs the same coefficients shares a
+// single copy of them (and its cache lines).
+//
+// publish() returns the existing block with the same values, compared bit
+// for bit, or creates one. Blocks are reference counted: a block stays
+// alive, unchanged, as long as any holder has it. Whoever reads a block
+// through a SharedCoefficients can therefore never see it retired.
+//
+// Letting go of the last reference is safe on the real-time thread: it
+// only pushes the block onto a lock-free list, without the mutex and
+// without freeing anything. collect() takes the blocks off that list,
+// removes them from the table and frees them; publish() and stats() call
+// it, and a non real-time thread should call it now and then so retired
+// blocks do not linger until the next design. publish(), stats() and
+// collect() take a mutex and allocate or free, so they belong outside
+// execute().
+class CoefficientRegistry
+{
+public:
+  struct Stats
+  {
+    size_t blocks;  // distinct coefficient sets alive
+    size_t users;  // references held to them
+    size_t bytes;  // coefficient storage, each block counted once
+  };
+
+  static CoefficientRegistry& global();
+
+  SharedCoefficients publish(std::span<const double> values);
+  Stats stats();
+  void collect();
+
+  CoefficientRegistry() = default;
+  ~CoefficientRegistry();
+  CoefficientRegistry(const CoefficientRegistry&) = delete;
+  CoefficientRegistry& operator=(const CoefficientRegistry&) = delete;
+
+private:
+  struct entry_t
+  {
+    const CoefficientBlock* block;
+    std::weak_ptr<const CoefficientBlock> weak;
+  };
+
+  void retire(const CoefficientBlock* block);
+  void collectLocked();
+
+  std::mutex mutex;
+  std::unordered_multimap<uint64_t, entry_t> entries;
+  std::atomic<const CoefficientBlock*> retired {nullptr};
+};
+
+}  // namespace fir_window
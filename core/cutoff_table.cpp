@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+
+#include "cutoff_table.hpp"
+
+namespace
+{
+// Linear interpolation of sin(pi lambda m) / (pi m) over a grid step d is
+// off by at most d^2 pi |m| / 8; the grid is made fine enough to keep
+// that under this tolerance at the outermost tap.
+constexpr double INTERPOLATION_TOLERANCE = 1e-5;
+
+double interpolation_error(double step, double half_length)
+{
+  return step * step * M_PI * std::max(half_length, 1.0) / 8;
+}
+}  // namespace
+
+void fir_window::CutoffTable::build(const DesignSpec& spec,
+                                    double min_cutoff,
+                                    double max_cutoff)
+{
+  num_taps = spec.num_taps;
+  low = std::clamp(std::min(min_cutoff, max_cutoff), 0.0, 1.0);
+  high = std::clamp(std::max(min_cutoff, max_cutoff), 0.0, 1.0);
+
+  const double half_length = static_cast<double>(num_taps - 1) / 2;
+  const double spacing = std::sqrt(8.0 * INTERPOLATION_TOLERANCE
+                                   / (M_PI * std::max(half_length, 1.0)));
+  row_length = (num_taps + 1) / 2;
+  const size_t max_points =
+      std::max<size_t>(MAX_BYTES / (row_length * sizeof(double)), 2);
+  points = static_cast<size_t>(std::ceil((high - low) / spacing)) + 1;
+  points = std::clamp<size_t>(points, 2, max_points);
+  step = (high - low) / static_cast<double>(points - 1);
+  max_error = interpolation_error(step, half_length);
+
+  const std::vector<double> window =
+      make_window(spec.window_shape, num_taps, spec.Kalpha, spec.Calpha);
+  centre_weight = window[num_taps / 2];
+  rows.assign(points * row_length, 0.0);
+  for (size_t row = 0; row < points; row++) {
+    const double lambda = low + step * static_cast<double>(row);
+    const std::vector<double> h =
+        ideal_response(num_taps, lambda, lambda, LOWPASS);
+    for (size_t n = 0; n < row_length; n++) {
+      rows[row * row_length + n] = h[n] * window[n];
+    }
+  }
+}
+
+void fir_window::CutoffTable::accumulate(double lambda,
+                                         double scale,
+                                         double* h) const
+{
+  const double position =
+      step > 0 ? (std::clamp(lambda, low, high) - low) / step : 0;
+  const size_t row = std::min(static_cast<size_t>(position), points - 2);
+  const double fraction = position - static_cast<double>(row);
+  const double* below = rows.data() + row * row_length;
+  const double* above = below + row_length;
+  const double weight_below = scale * (1.0 - fraction);
+  const double weight_above = scale * fraction;
+  for (size_t n = 0; n < row_length; n++) {
+    h[n] += weight_below * below[n] + weight_above * above[n];
+  }
+}
+
+void fir_window::CutoffTable::design(filter_t type,
+                                     double lambda1,
+                                     double lambda2,
+                                     double* h) const
+{
+  std::fill(h, h + num_taps, 0.0);
+  switch (type) {
+    case LOWPASS:
+      accumulate(lambda1, 1.0, h);
+      break;
+    case HIGHPASS:
+      h[num_taps / 2] = centre_weight;
+      accumulate(lambda1, -1.0, h);
+      break;
+    case BANDPASS:
+      accumulate(lambda2, 1.0, h);
+      accumulate(lambda1, -1.0, h);
+      break;
+    case BANDSTOP:
+      h[num_taps / 2] = centre_weight;
+      accumulate(lambda2, -1.0, h);
+      accumulate(lambda1, 1.0, h);
+      break;
+    case MOVING_AVERAGE:
+      // has no cutoff to move
+      break;
+  }
+  // every design is symmetric about the centre tap
+  for (size_t n = 0; n < num_taps / 2; n++) {
+    h[num_taps - 1 - n] = h[n];
+  }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+#include "design.hpp"
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// Precomputed windowed lowpass prototypes w[n] sin(pi lambda m) / (pi m),
+// tabulated on a uniform grid of cutoffs. Any window design can then be
+// regenerated for a new cutoff with one linear interpolation between two
+// table rows per tap: O(N), no allocation and no trigonometry, so it is
+// safe to call from the real-time thread.
+//
+// The grid is made fine enough for every interpolated tap to be within
+// 1e-5 of the full redesign (twice that for bandpass and bandstop, which
+// add two prototypes), as long as the table fits in MAX_BYTES. Rows are
+// symmetric, so only half of each is stored: 1001 taps over cutoffs 0.05
+// to 0.4 take about 1550 rows and 6 MB. Longer filters or wider ranges
+// get a coarser grid instead of more memory; interpolationError() gives
+// the bound actually reached.
+class CutoffTable
+{
+public:
+  static constexpr size_t MAX_BYTES = size_t {32} << 20;
+
+  // design time: tabulates the window of spec for cutoffs between
+  // min_cutoff and max_cutoff (fractions of Pi)
+  void build(const DesignSpec& spec, double min_cutoff, double max_cutoff);
+
+  // Writes the windowed design of the given type into h (taps() values).
+  // Cutoffs are clamped to the tabulated range.
+  void design(filter_t type, double lambda1, double lambda2, double* h) const;
+
+  size_t taps() const { return num_taps; }
+  double minCutoff() const { return low; }
+  double maxCutoff() const { return high; }
+  // largest difference between an interpolated prototype tap and the
+  // exact one
+  double interpolationError() const { return max_error; }
+
+private:
+  // h += scale * windowed lowpass(lambda)
+  void accumulate(double lambda, double scale, double* h) const;
+
+  size_t num_taps = 0;
+  size_t points = 0;
+  double low = 0;
+  double high = 0;
+  double step = 0;
+  size_t row_length = 0;  // taps 0 to the centre
+  double max_error = 0;
+  double centre_weight = 1;  // window value at the centre tap
+  rt_vector<double> rows;  // points x row_length
+};
+
+}  // namespace fir_window
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// Mirrored delay line: every sample is written twice, once at the write
+// position and once length() slots further on. The most recent length()
+// samples are therefore always contiguous in memory, oldest first, and a
+// kernel can stream over them without wrapping or modulo arithmetic.
+class DelayLine
+{
+public:
+  void resize(size_t length)
+  {
+    len = length;
+    pos = 0;
+    buffer.assign(2 * length, 0.0);
+  }
+
+  void clear()
+  {
+    pos = 0;
+    std::fill(buffer.begin(), buffer.end(), 0.0);
+  }
+
+  void push(double sample)
+  {
+    buffer[pos] = sample;
+    buffer[pos + len] = sample;
+    if (++pos == len) {
+      pos = 0;
+    }
+  }
+
+  // Takes over the samples of a delay line of the same length; does
+  // nothing otherwise. No allocation.
+  void copyFrom(const DelayLine& other)
+  {
+    if (other.len == len) {
+      std::copy(other.buffer.begin(), other.buffer.end(), buffer.begin());
+      pos = other.pos;
+    }
+  }
+
+  // oldest sample first, newest sample at data()[length() - 1]
+  const double* data() const { return buffer.data() + pos; }
+  size_t length() const { return len; }
+
+private:
+  rt_vector<double> buffer;
+  size_t len = 0;
+  size_t pos = 0;
+};
+
+}  // namespace fir_window
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cmath>
+
+#include "design.hpp"
+#include "min_phase.hpp"
+#include "optimal_design.hpp"
+
+namespace
+{
+
+// modified Bessel function of the first kind, order zero
+double bessel_i0(double x)
+{
+  double sum = 1;
+  double term = 1;
+  const double quarter_x2 = x * x / 4;
+  for (int k = 1; k < 500; k++) {
+    term *= quarter_x2 / (static_cast<double>(k) * k);
+    sum += term;
+    if (term < sum * 1e-17) {
+      break;
+    }
+  }
+  return sum;
+}
+
+// Chebyshev polynomial of the first kind, valid for any real x
+double chebyshev_poly(double order, double x)
+{
+  if (std::fabs(x) <= 1) {
+    return std::cos(order * std::acos(x));
+  }
+  const double value = std::cosh(order * std::acosh(std::fabs(x)));
+  return (x < 0 && std::fmod(order, 2.0) != 0) ? -value : value;
+}
+
+// Dolph-Chebyshev window by sampling its spectrum on N points and taking
+// the inverse DFT. The DFT uses a cosine table indexed modulo N, so the
+// cost is O(N^2 / 4) multiply-adds without further trigonometry.
+std::vector<double> dolph_chebyshev(size_t length, double attenuation_db)
+{
+  std::vector<double> window(length, 1.0);
+  if (length < 2) {
+    return window;
+  }
+  const double order = static_cast<double>(length - 1);
+  const double ripple = std::pow(10.0, attenuation_db / 20.0);
+  const double x0 = std::cosh(std::acosh(ripple) / order);
+
+  std::vector<double> cosines(length);
+  for (size_t i = 0; i < length; i++) {
+    cosines[i] = std::cos(2.0 * M_PI * static_cast<double>(i) / length);
+  }
+  const size_t half = (length - 1) / 2;
+  std::vector<double> spectrum(half + 1);
+  for (size_t k = 0; k <= half; k++) {
+    spectrum[k] = chebyshev_poly(
+        order, x0 * std::cos(M_PI * static_cast<double>(k) / length));
+  }
+
+  const size_t centre = (length - 1) / 2;
+  for (size_t n = 0; n <= centre; n++) {
+    const size_t offset = centre - n;
+    double sum = spectrum[0];
+    for (size_t k = 1; k <= half; k++) {
+      sum += 2.0 * spectrum[k] * cosines[(k * offset) % length];
+    }
+    window[n] = sum;
+    window[length - 1 - n] = sum;
+  }
+  const double peak = *std::max_element(window.begin(), window.end());
+  for (auto& value : window) {
+    value /= peak;
+  }
+  return window;
+}
+
+}  // namespace
+
+std::vector<double> fir_window::make_window(window_t shape,
+                                            size_t length,
+                                            double Kalpha,
+                                            double Calpha)
+{
+  std::vector<double> window(length, 1.0);
+  if (length < 2) {
+    return window;
+  }
+  const double span = static_cast<double>(length - 1);
+  switch (shape) {
+    case RECT:  // rectangular
+      break;
+
+    case TRI:  // triangular
+      for (size_t n = 0; n < length; n++) {
+        window[n] = 1.0 - std::fabs(2.0 * static_cast<double>(n) - span) / span;
+      }
+      break;
+
+    case HAMM:  // Hamming
+      for (size_t n = 0; n < length; n++) {
+        window[n] = 0.54 - 0.46 * std::cos(2.0 * M_PI * n / span);
+      }
+      break;
+
+    case HANN:  // Hann
+      for (size_t n = 0; n < length; n++) {
+        window[n] = 0.5 - 0.5 * std::cos(2.0 * M_PI * n / span);
+      }
+      break;
+
+    case CHEBY:  // Dolph-Chebyshev
+      window = dolph_chebyshev(length, Calpha);
+      break;
+
+    case KAISER:
+      for (size_t n = 0; n < length; n++) {
+        const double ratio = 2.0 * static_cast<double>(n) / span - 1.0;
+        window[n] = bessel_i0(Kalpha * std::sqrt(1.0 - ratio * ratio))
+            / bessel_i0(Kalpha);
+      }
+      break;
+  }  // end of switch on window shape
+  return window;
+}
+
+std::vector<double> fir_window::ideal_response(size_t num_taps,
+                                               double lambda1,
+                                               double lambda2,
+                                               filter_t type)
+{
+  std::vector<double> h(num_taps);
+  const double centre = static_cast<double>(num_taps - 1) / 2;
+  for (size_t n = 0; n < num_taps; n++) {
+    const double m = static_cast<double>(n) - centre;
+    // ideal lowpass with cutoff lambda, sampled at offset m
+    const auto lowpass = [m](double lambda)
+    { return m == 0 ? lambda : std::sin(M_PI * lambda * m) / (M_PI * m); };
+    const double impulse = m == 0 ? 1.0 : 0.0;
+    switch (type) {
+      case LOWPASS:
+        h[n] = lowpass(lambda1);
+        break;
+      case HIGHPASS:
+        h[n] = impulse - lowpass(lambda1);
+        break;
+      case BANDPASS:
+        h[n] = lowpass(lambda2) - lowpass(lambda1);
+        break;
+      case BANDSTOP:
+        h[n] = impulse - lowpass(lambda2) + lowpass(lambda1);
+        break;
+      case MOVING_AVERAGE:
+        h[n] = 1.0 / static_cast<double>(num_taps);
+        break;
+    }
+  }
+  return h;
+}
+
+std::vector<double> fir_window::quadrature_response(size_t num_taps,
+                                                    double lambda1,
+                                                    double lambda2)
+{
+  std::vector<double> h(num_taps);
+  const double centre = static_cast<double>(num_taps - 1) / 2;
+  for (size_t n = 0; n < num_taps; n++) {
+    const double m = static_cast<double>(n) - centre;
+    if (m != 0) {
+      h[n] = (std::cos(M_PI * lambda1 * m) - std::cos(M_PI * lambda2 * m))
+          / (M_PI * m);
+    }
+  }
+  return h;
+}
+
+std::vector<double> fir_window::design_filter(const DesignSpec& spec)
+{
+  if (spec.filter_type == MOVING_AVERAGE) {
+    // nothing to shape: window, method and phase do not apply
+    return ideal_response(spec.num_taps, 0, 0, MOVING_AVERAGE);
+  }
+  std::vector<double> h;
+  switch (spec.method) {
+    case WINDOW_METHOD: {
+      h = ideal_response(
+          spec.num_taps, spec.lambda1, spec.lambda2, spec.filter_type);
+      const std::vector<double> window = make_window(
+          spec.window_shape, spec.num_taps, spec.Kalpha, spec.Calpha);
+      for (size_t n = 0; n < h.size(); n++) {
+        h[n] *= window[n];
+      }
+      break;
+    }
+    case EQUIRIPPLE:
+      h = design_equiripple(spec.num_taps, design_bands(spec));
+      break;
+    case LEAST_SQUARES:
+      h = design_least_squares(spec.num_taps, design_bands(spec));
+      break;
+  }
+  if (spec.phase_response == MINIMUM_PHASE) {
+    h = minimum_phase(h.data(), h.size());
+  }
+  return h;
+}
+
+std::vector<double> fir_window::design_quadrature(const DesignSpec& spec)
+{
+  std::vector<double> h =
+      quadrature_response(spec.num_taps, spec.lambda1, spec.lambda2);
+  const std::vector<double> window =
+      make_window(spec.window_shape, spec.num_taps, spec.Kalpha, spec.Calpha);
+  for (size_t n = 0; n < h.size(); n++) {
+    h[n] *= window[n];
+  }
+  return h;
+}
+
+size_t fir_window::odd_taps(int64_t num_taps)
+{
+  if (num_taps < 1) {
+    return 1;
+  }
+  return num_taps % 2 == 0 ? static_cast<size_t>(num_taps + 1)
+                           : static_cast<size_t>(num_taps);
+}
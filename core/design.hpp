@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fir_window
+{
+
+enum window_t : int64_t
+{
+  RECT = 0,
+  TRI,
+  HAMM,
+  HANN,
+  CHEBY,
+  KAISER
+};
+
+enum filter_t : int64_t
+{
+  LOWPASS = 0,
+  HIGHPASS,
+  BANDPASS,
+  BANDSTOP,
+  MOVING_AVERAGE  // boxcar of num_taps samples, run as a running sum
+};
+
+enum phase_t : int64_t
+{
+  LINEAR_PHASE = 0,
+  MINIMUM_PHASE
+};
+
+enum method_t : int64_t
+{
+  WINDOW_METHOD = 0,  // ideal response times a window
+  EQUIRIPPLE,  // Parks-McClellan, minimax error
+  LEAST_SQUARES  // minimum integrated squared error
+};
+
+// Bump whenever a change to the design code changes its output, so that
+// coefficients cached by an older version are no longer used.
+constexpr uint32_t DESIGN_VERSION = 2;
+
+// Everything that determines a set of filter coefficients. Cutoffs are
+// fractions of Pi (1.0 is the Nyquist frequency).
+struct DesignSpec
+{
+  window_t window_shape = HAMM;
+  filter_t filter_type = LOWPASS;
+  size_t num_taps = 9;  // odd, Type I
+  double lambda1 = 0.1;
+  double lambda2 = 0.6;  // bandpass/bandstop only
+  double Kalpha = 1.5;  // Kaiser window shape parameter
+  double Calpha = 70;  // Dolph-Chebyshev sidelobe attenuation, dB
+  phase_t phase_response = LINEAR_PHASE;
+  method_t method = WINDOW_METHOD;
+  // equiripple and least squares only: width of the transition band
+  // centred on each cutoff, and the stopband error weight relative to the
+  // passband
+  double transition = 0.05;
+  double stopband_weight = 1;
+};
+
+// Window of the given length, peak normalized to 1. The triangular and
+// Hann windows are the variants whose end points are zero.
+std::vector<double> make_window(window_t shape,
+                                size_t length,
+                                double Kalpha,
+                                double Calpha);
+
+// Truncated impulse response of the ideal filter, centred on tap
+// (num_taps - 1) / 2
+std::vector<double> ideal_response(size_t num_taps,
+                                   double lambda1,
+                                   double lambda2,
+                                   filter_t type);
+
+// Truncated impulse response of the ideal Hilbert transformer restricted
+// to the band lambda1..lambda2: the quadrature partner of the BANDPASS
+// ideal response. Antisymmetric about the centre tap.
+std::vector<double> quadrature_response(size_t num_taps,
+                                        double lambda1,
+                                        double lambda2);
+
+// Window method, equiripple or least squares design as selected by
+// spec.method, converted to minimum phase when requested. h[0] applies to
+// the newest sample. A MOVING_AVERAGE is always the plain num_taps point
+// boxcar.
+std::vector<double> design_filter(const DesignSpec& spec);
+
+// Windowed quadrature_response() for the band of spec. Always the window
+// method with linear phase, so its delay matches the linear-phase window
+// method bandpass design exactly.
+std::vector<double> design_quadrature(const DesignSpec& spec);
+
+// the first tap count the design code accepts that is at least num_taps
+size_t odd_taps(int64_t num_taps);
+
+}  // namespace fir_window
@@ -0,0 +1,73 @@
+#include <cmath>
+#include <utility>
+
+#include "fft.hpp"
+
+fir_window::FftPlan::FftPlan(size_t size)
+    : n(sizeFor(size))
+    , bit_reverse(n)
+    , twiddles(n / 2)
+{
+  size_t bits = 0;
+  while ((size_t {1} << bits) < n) {
+    bits++;
+  }
+  for (size_t i = 0; i < n; i++) {
+    size_t reversed = 0;
+    for (size_t bit = 0; bit < bits; bit++) {
+      reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+    }
+    bit_reverse[i] = reversed;
+  }
+  for (size_t k = 0; k < n / 2; k++) {
+    twiddles[k] = std::polar(1.0, -2.0 * M_PI * static_cast<double>(k) / n);
+  }
+}
+
+size_t fir_window::FftPlan::sizeFor(size_t minimum)
+{
+  size_t size = 1;
+  while (size < minimum) {
+    size <<= 1;
+  }
+  return size;
+}
+
+void fir_window::FftPlan::forward(std::complex<double>* data) const
+{
+  transform(data, false);
+}
+
+void fir_window::FftPlan::inverse(std::complex<double>* data) const
+{
+  transform(data, true);
+  const double scale = 1.0 / static_cast<double>(n);
+  for (size_t i = 0; i < n; i++) {
+    data[i] *= scale;
+  }
+}
+
+void fir_window::FftPlan::transform(std::complex<double>* data,
+                                    bool inverse) const
+{
+  for (size_t i = 0; i < n; i++) {
+    if (i < bit_reverse[i]) {
+      std::swap(data[i], data[bit_reverse[i]]);
+    }
+  }
+  for (size_t length = 2; length <= n; length <<= 1) {
+    const size_t half = length / 2;
+    const size_t stride = n / length;
+    for (size_t start = 0; start < n; start += length) {
+      for (size_t k = 0; k < half; k++) {
+        std::complex<double> w = twiddles[k * stride];
+        if (inverse) {
+          w = std::conj(w);
+        }
+        const std::complex<double> odd = w * data[start + k + half];
+        data[start + k + half] = data[start + k] - odd;
+        data[start + k] += odd;
+      }
+    }
+  }
+}
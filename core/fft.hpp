@@ -0,0 +1,37 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// Precomputed radix-2 complex FFT. All tables are built by the
+// constructor, so forward() and inverse() neither allocate nor call any
+// trigonometric functions and may run on the real-time thread.
+class FftPlan
+{
+public:
+  explicit FftPlan(size_t n = 1);
+
+  size_t size() const { return n; }
+
+  // in place, data holds size() values
+  void forward(std::complex<double>* data) const;
+  // in place, scaled by 1 / size()
+  void inverse(std::complex<double>* data) const;
+
+  // smallest power of two that is at least minimum
+  static size_t sizeFor(size_t minimum);
+
+private:
+  void transform(std::complex<double>* data, bool inverse) const;
+
+  size_t n;
+  rt_vector<size_t> bit_reverse;
+  rt_vector<std::complex<double>> twiddles;  // exp(-2 pi i k / n)
+};
+
+}  // namespace fir_window
@@ -0,0 +1,80 @@
+#include <algorithm>
+
+#include "filter_bank.hpp"
+
+void fir_window::FilterBank::resize(size_t bands, size_t taps)
+{
+  num_bands = bands;
+  padded_bands = (bands + BAND_BLOCK - 1) / BAND_BLOCK * BAND_BLOCK;
+  own.assign(padded_bands * taps, 0.0);
+  coefficients = own.data();
+  shared.reset();
+  // a redesign with the same length keeps the input history
+  if (taps != num_taps) {
+    num_taps = taps;
+    history.resize(taps);
+  }
+}
+
+void fir_window::FilterBank::clear()
+{
+  history.clear();
+}
+
+void fir_window::FilterBank::setBand(size_t band, const double* h)
+{
+  for (size_t i = 0; i < num_taps; i++) {
+    own[i * padded_bands + band] = h[num_taps - 1 - i];
+  }
+}
+
+void fir_window::FilterBank::share()
+{
+  shared = CoefficientRegistry::global().publish(own);
+  coefficients = shared->data();
+  own = {};
+}
+
+void fir_window::FilterBank::blockSums(size_t block,
+                                       size_t first_tap,
+                                       size_t last_tap,
+                                       double* acc) const
+{
+  const double* x = history.data();
+  // one history load feeds BAND_BLOCK accumulators held in registers
+  double acc0 = 0;
+  double acc1 = 0;
+  double acc2 = 0;
+  double acc3 = 0;
+  const double* c = coefficients + first_tap * padded_bands + block;
+  for (size_t i = first_tap; i < last_tap; i++, c += padded_bands) {
+    const double sample = x[i];
+    acc0 += c[0] * sample;
+    acc1 += c[1] * sample;
+    acc2 += c[2] * sample;
+    acc3 += c[3] * sample;
+  }
+  acc[0] = acc0;
+  acc[1] = acc1;
+  acc[2] = acc2;
+  acc[3] = acc3;
+}
+
+void fir_window::FilterBank::compute(double* out) const
+{
+  for (size_t block = 0; block < padded_bands; block += BAND_BLOCK) {
+    double acc[BAND_BLOCK];
+    blockSums(block, 0, num_taps, acc);
+    const size_t count = std::min(BAND_BLOCK, num_bands - block);
+    std::copy(acc, acc + count, out + block);
+  }
+}
+
+void fir_window::FilterBank::computeRange(size_t first_tap,
+                                          size_t last_tap,
+                                          double* partial) const
+{
+  for (size_t block = 0; block < padded_bands; block += BAND_BLOCK) {
+    blockSums(block, first_tap, last_tap, partial + block);
+  }
+}
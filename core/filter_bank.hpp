@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+
+#include "coefficient_registry.hpp"
+#include "delay_line.hpp"
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// K FIR filters of equal length sharing one delay line. Coefficients are
+// kept as a tap-major K x N matrix so each output period is a single
+// matrix-vector product against the input history.
+class FilterBank
+{
+public:
+  // number of bands whose outputs share one pass over the history
+  static constexpr size_t BAND_BLOCK = 4;
+
+  void resize(size_t bands, size_t taps);
+  void clear();
+
+  // h holds taps() coefficients in natural order, h[0] applied to the
+  // newest sample
+  void setBand(size_t band, const double* h);
+
+  // Moves the coefficient matrix into the global CoefficientRegistry, to
+  // be shared with every bank of the same design. Call after the last
+  // setBand(); the next resize() starts a private matrix again.
+  // Allocates and locks: not for the per-sample path.
+  void share();
+
+  void push(double sample) { history.push(sample); }
+  // takes over the history of a bank with as many taps
+  void copyHistory(const FilterBank& other)
+  {
+    history.copyFrom(other.history);
+  }
+
+  // writes bands() outputs for the current history
+  void compute(double* out) const;
+
+  // Partial sums over the taps [first_tap, last_tap) of the history,
+  // written to paddedBands() values. Summing the partials of consecutive
+  // tap ranges gives compute(); disjoint ranges may run concurrently.
+  void computeRange(size_t first_tap, size_t last_tap, double* partial) const;
+
+  size_t bands() const { return num_bands; }
+  size_t paddedBands() const { return padded_bands; }
+  size_t taps() const { return num_taps; }
+
+private:
+  // one BAND_BLOCK of bands over taps [first_tap, last_tap) into acc
+  void blockSums(size_t block,
+                 size_t first_tap,
+                 size_t last_tap,
+                 double* acc) const;
+
+  size_t num_bands = 0;
+  size_t padded_bands = 0;
+  size_t num_taps = 0;
+
+  // coefficients[i * padded_bands + band] multiplies history.data()[i],
+  // i.e. every band's impulse response stored time reversed. Points into
+  // own while the bands are set, into shared after share().
+  const double* coefficients = nullptr;
+  rt_vector<double> own;
+  SharedCoefficients shared;
+  DelayLine history;
+};
+
+}  // namespace fir_window
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+#include "fir_filter.hpp"
+
+void fir_window::FirFilter::resizeHistory(size_t taps)
+{
+  if (taps != num_taps) {
+    num_taps = taps;
+    history.resize(taps);
+    staging.assign(taps - 1 + CHUNK, 0.0);
+  }
+}
+
+void fir_window::FirFilter::setCoefficients(const double* h, size_t taps)
+{
+  resizeHistory(taps);
+  own.assign(h, h + taps);
+  std::reverse(own.begin(), own.end());
+  reversed = own.data();
+  shared.reset();
+}
+
+void fir_window::FirFilter::shareCoefficients(const double* h, size_t taps)
+{
+  resizeHistory(taps);
+  const std::vector<double> time_reversed(std::make_reverse_iterator(h + taps),
+                                          std::make_reverse_iterator(h));
+  shared = CoefficientRegistry::global().publish(time_reversed);
+  reversed = shared->data();
+  own = {};
+}
+
+double fir_window::FirFilter::process(double input)
+{
+  history.push(input);
+  return std::inner_product(
+      reversed, reversed + num_taps, history.data(), 0.0);
+}
+
+void fir_window::FirFilter::process(std::span<const double> in,
+                                    std::span<double> out)
+{
+  if (num_taps == 0) {
+    std::fill(out.begin(), out.begin() + in.size(), 0.0);
+    return;
+  }
+  const double* c = reversed;
+  for (size_t done = 0; done < in.size(); done += CHUNK) {
+    const size_t count = std::min(CHUNK, in.size() - done);
+    // output n of the chunk reads staging[n .. n + num_taps)
+    std::copy_n(history.data() + 1, num_taps - 1, staging.begin());
+    std::copy_n(in.begin() + done, count, staging.begin() + num_taps - 1);
+    const double* x = staging.data();
+    double* y = out.data() + done;
+
+    size_t n = 0;
+    for (; n + OUTPUT_BLOCK <= count; n += OUTPUT_BLOCK) {
+      // accumulating in tap order keeps every sum identical to the
+      // per-sample inner product
+      double acc0 = 0;
+      double acc1 = 0;
+      double acc2 = 0;
+      double acc3 = 0;
+      const double* window = x + n;
+      for (size_t i = 0; i < num_taps; i++) {
+        const double coefficient = c[i];
+        acc0 += coefficient * window[i];
+        acc1 += coefficient * window[i + 1];
+        acc2 += coefficient * window[i + 2];
+        acc3 += coefficient * window[i + 3];
+      }
+      y[n] = acc0;
+      y[n + 1] = acc1;
+      y[n + 2] = acc2;
+      y[n + 3] = acc3;
+    }
+    for (; n < count; n++) {
+      y[n] = std::inner_product(c, c + num_taps, x + n, 0.0);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      history.push(in[done + i]);
+    }
+  }
+}
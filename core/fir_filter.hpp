@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "coefficient_registry.hpp"
+#include "delay_line.hpp"
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// Direct-form FIR filter: y[n] = sum_k h[k] x[n - k], one dot product over
+// a contiguous delay line per sample.
+class FirFilter
+{
+public:
+  // outputs computed together, sharing each coefficient load
+  static constexpr size_t OUTPUT_BLOCK = 4;
+  // samples staged per pass of the block kernel
+  static constexpr size_t CHUNK = 256;
+
+  // h[0] applies to the newest sample. The history survives a change of
+  // coefficients as long as the number of taps stays the same. The taps
+  // are copied into storage of this filter, so changing them without
+  // changing their number does not allocate.
+  void setCoefficients(const double* h, size_t num_taps);
+
+  // As setCoefficients(), but the taps are published to the global
+  // CoefficientRegistry and shared with every filter running the same
+  // ones. Allocates and locks: not for the per-sample path.
+  void shareCoefficients(const double* h, size_t num_taps);
+
+  // adds one sample to the history and returns the filter output
+  double process(double input);
+
+  // Filters in.size() samples into out, which must be as long. Each
+  // output is the same sum in the same order as process(double) computes
+  // and the history ends up identical. No allocation.
+  void process(std::span<const double> in, std::span<double> out);
+
+  // adds one sample to the history without computing an output
+  void push(double input) { history.push(input); }
+
+  void clear() { history.clear(); }
+  // takes over the history of a filter with as many taps
+  void copyHistory(const FirFilter& other) { history.copyFrom(other.history); }
+  size_t taps() const { return num_taps; }
+
+private:
+  void resizeHistory(size_t taps);
+
+  // h time reversed, oldest sample first: points into own or shared
+  const double* reversed = nullptr;
+  size_t num_taps = 0;
+  rt_vector<double> own;
+  SharedCoefficients shared;
+  DelayLine history;
+  // the last taps() - 1 history samples followed by up to CHUNK inputs,
+  // so that every output of a chunk reads one contiguous window
+  rt_vector<double> staging;
+};
+
+}  // namespace fir_window
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#include "fft.hpp"
+#include "min_phase.hpp"
+
+namespace
+{
+// cepstral aliasing falls off with the transform length
+constexpr size_t OVERSAMPLING = 64;
+constexpr size_t MIN_FFT_SIZE = 4096;
+// stopband zeros of the linear-phase design would send log|H| to -inf;
+// clamp them to this far below the peak magnitude (-200 dB)
+constexpr double MAGNITUDE_FLOOR = 1e-10;
+}  // namespace
+
+std::vector<double> fir_window::minimum_phase(const double* h,
+                                              size_t num_taps)
+{
+  const FftPlan plan(std::max(MIN_FFT_SIZE, OVERSAMPLING * num_taps));
+  const size_t n = plan.size();
+  std::vector<std::complex<double>> spectrum(n);
+  std::copy(h, h + num_taps, spectrum.begin());
+  plan.forward(spectrum.data());
+
+  double peak = 0;
+  for (const auto& bin : spectrum) {
+    peak = std::max(peak, std::abs(bin));
+  }
+  const double floor = peak * MAGNITUDE_FLOOR;
+  for (auto& bin : spectrum) {
+    bin = std::log(std::max(std::abs(bin), floor));
+  }
+
+  // real cepstrum, then fold the anticausal half onto the causal half
+  plan.inverse(spectrum.data());
+  for (size_t i = 1; i < n / 2; i++) {
+    spectrum[i] = 2.0 * spectrum[i].real();
+  }
+  spectrum[0] = spectrum[0].real();
+  spectrum[n / 2] = spectrum[n / 2].real();
+  std::fill(spectrum.begin() + n / 2 + 1, spectrum.end(), 0.0);
+
+  plan.forward(spectrum.data());
+  for (auto& bin : spectrum) {
+    bin = std::exp(bin);
+  }
+  plan.inverse(spectrum.data());
+
+  std::vector<double> result(num_taps);
+  for (size_t i = 0; i < num_taps; i++) {
+    result[i] = spectrum[i].real();
+  }
+  return result;
+}
+
+double fir_window::group_delay(const double* h, size_t num_taps, double omega)
+{
+  // tau(w) = Re{ DTFT(n h[n]) / DTFT(h[n]) }
+  std::complex<double> response = 0;
+  std::complex<double> ramp_response = 0;
+  for (size_t i = 0; i < num_taps; i++) {
+    const std::complex<double> phasor =
+        std::polar(1.0, -omega * static_cast<double>(i));
+    response += h[i] * phasor;
+    ramp_response += static_cast<double>(i) * h[i] * phasor;
+  }
+  if (std::abs(response) == 0) {
+    return 0;
+  }
+  return (ramp_response / response).real();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace fir_window
+{
+
+// Converts an FIR design into the minimum-phase filter with the same
+// magnitude response using the real cepstrum (homomorphic method). The
+// result has the same number of taps, with its energy packed towards
+// h[0] instead of centred on (num_taps - 1) / 2.
+std::vector<double> minimum_phase(const double* h, size_t num_taps);
+
+// Group delay of h in samples at normalized frequency omega (rad/sample)
+double group_delay(const double* h, size_t num_taps, double omega);
+
+}  // namespace fir_window
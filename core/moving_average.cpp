@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+
+#include "moving_average.hpp"
+
+namespace
+{
+
+// Neumaier's compensated addition of value to sum + compensation
+void accumulate(double& sum, double& compensation, double value)
+{
+  const double total = sum + value;
+  if (std::fabs(sum) >= std::fabs(value)) {
+    compensation += (sum - total) + value;
+  } else {
+    compensation += (value - total) + sum;
+  }
+  sum = total;
+}
+
+}  // namespace
+
+void fir_window::MovingAverage::configure(size_t length, size_t stages)
+{
+  len = std::max<size_t>(length, 1);
+  num_stages = std::clamp<size_t>(stages, 1, MAX_STAGES);
+  scale = 1.0 / static_cast<double>(len);
+  for (size_t s = 0; s < MAX_STAGES; s++) {
+    stage[s].window.resize(s < num_stages ? len : 0);
+    stage[s].sum = 0;
+    stage[s].compensation = 0;
+  }
+}
+
+double fir_window::MovingAverage::process(double input)
+{
+  double x = input;
+  for (size_t s = 0; s < num_stages; s++) {
+    stage_t& st = stage[s];
+    // the oldest sample of the window is the one pushed out
+    const double leaving = st.window.data()[0];
+    st.window.push(x);
+    accumulate(st.sum, st.compensation, x);
+    accumulate(st.sum, st.compensation, -leaving);
+    x = (st.sum + st.compensation) * scale;
+  }
+  return x;
+}
+
+void fir_window::MovingAverage::process(std::span<const double> in,
+                                        std::span<double> out)
+{
+  for (size_t n = 0; n < in.size(); n++) {
+    out[n] = process(in[n]);
+  }
+}
+
+void fir_window::MovingAverage::clear()
+{
+  for (size_t s = 0; s < num_stages; s++) {
+    stage[s].window.clear();
+    stage[s].sum = 0;
+    stage[s].compensation = 0;
+  }
+}
+
+void fir_window::MovingAverage::copyHistory(const MovingAverage& other)
+{
+  if (other.len != len || other.num_stages != num_stages) {
+    return;
+  }
+  for (size_t s = 0; s < num_stages; s++) {
+    stage[s].window.copyFrom(other.stage[s].window);
+    stage[s].sum = other.stage[s].sum;
+    stage[s].compensation = other.stage[s].compensation;
+  }
+}
+
+std::vector<double> fir_window::moving_average_response(size_t length,
+                                                        size_t stages)
+{
+  length = std::max<size_t>(length, 1);
+  stages = std::clamp<size_t>(stages, 1, MovingAverage::MAX_STAGES);
+  std::vector<double> h {1.0};
+  const double scale = 1.0 / static_cast<double>(length);
+  for (size_t s = 0; s < stages; s++) {
+    // boxcar convolution as a sliding sum over h
+    std::vector<double> next(h.size() + length - 1);
+    double window = 0;
+    for (size_t m = 0; m < next.size(); m++) {
+      if (m < h.size()) {
+        window += h[m];
+      }
+      if (m >= length) {
+        window -= h[m - length];
+      }
+      next[m] = window * scale;
+    }
+    h = std::move(next);
+  }
+  return h;
+}
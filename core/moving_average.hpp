@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "delay_line.hpp"
+
+namespace fir_window
+{
+
+// Cascade of N-point moving averages, the response of a CIC filter without
+// the rate change: H(z) = ((1 - z^-N) / (N (1 - z^-1)))^S. Every stage
+// keeps a running sum of its last N inputs, adding the newest and
+// subtracting the one that leaves the window, so a sample costs a few adds
+// per stage whatever N is.
+//
+// The sums are compensated (Neumaier), which carries the rounding error
+// of each add in a second term. The running sum therefore stays within
+// rounding of the exact window sum however long the filter runs, where a
+// plain running sum would random-walk away from it. A non-finite input
+// stays in the sums until clear().
+class MovingAverage
+{
+public:
+  static constexpr size_t MAX_STAGES = 8;
+
+  // length >= 1 samples per stage, 1 <= stages <= MAX_STAGES. Clears the
+  // history.
+  void configure(size_t length, size_t stages);
+
+  double process(double input);
+  // in.size() outputs into out, the same as calling process(double) on each
+  void process(std::span<const double> in, std::span<double> out);
+
+  void clear();
+  // takes over the windows and sums of a cascade of the same length and
+  // stages; otherwise leaves this one as it is
+  void copyHistory(const MovingAverage& other);
+
+  size_t length() const { return len; }
+  size_t stages() const { return num_stages; }
+  // (length - 1) * stages / 2 samples at every frequency
+  double groupDelay() const
+  {
+    return static_cast<double>((len - 1) * num_stages) / 2;
+  }
+
+private:
+  struct stage_t
+  {
+    DelayLine window;
+    double sum = 0;
+    double compensation = 0;
+  };
+
+  std::array<stage_t, MAX_STAGES> stage;
+  size_t num_stages = 0;
+  size_t len = 0;
+  double scale = 0;  // 1 / length
+};
+
+// Impulse response of the cascade: (length - 1) * stages + 1 taps,
+// symmetric, unity DC gain. For checking the filter against a direct
+// convolution; the filter itself never convolves with it.
+std::vector<double> moving_average_response(size_t length, size_t stages);
+
+}  // namespace fir_window
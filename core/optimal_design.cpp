@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "optimal_design.hpp"
+
+namespace
+{
+
+using fir_window::band_t;
+
+// dense grid points per unknown coefficient in the Remez exchange
+constexpr size_t GRID_DENSITY = 16;
+constexpr int MAX_ITERATIONS = 100;
+// relative spread of the extremal errors at which the exchange stops
+constexpr double CONVERGENCE = 1e-7;
+
+// Barycentric weight of node k among nodes x[0..count). Factors are taken
+// in interleaved subsets and doubled so that the product neither
+// overflows nor underflows for hundreds of nodes.
+double barycentric_weight(const std::vector<double>& x, size_t k, size_t count)
+{
+  const size_t stride = (count - 1) / 15 + 1;
+  double denominator = 1;
+  for (size_t start = 0; start < stride; start++) {
+    for (size_t j = start; j < count; j += stride) {
+      if (j != k) {
+        denominator *= 2.0 * (x[k] - x[j]);
+      }
+    }
+  }
+  return 1.0 / denominator;
+}
+
+// Interpolating polynomial through (x[k], y[k]), k < weights.size(),
+// evaluated at point in barycentric form
+double interpolate(const std::vector<double>& x,
+                   const std::vector<double>& y,
+                   const std::vector<double>& weights,
+                   double point)
+{
+  double numerator = 0;
+  double denominator = 0;
+  for (size_t k = 0; k < weights.size(); k++) {
+    const double difference = point - x[k];
+    if (std::fabs(difference) < 1e-14) {
+      return y[k];
+    }
+    const double term = weights[k] / difference;
+    numerator += term * y[k];
+    denominator += term;
+  }
+  return numerator / denominator;
+}
+
+// Symmetric taps from the cosine series A(w) = sum_k a[k] cos(k w), with
+// M = a.size() - 1 and 2M + 1 taps
+std::vector<double> taps_from_cosine_series(const std::vector<double>& a)
+{
+  const size_t order = a.size() - 1;
+  std::vector<double> h(2 * order + 1);
+  h[order] = a[0];
+  for (size_t k = 1; k <= order; k++) {
+    h[order - k] = a[k] / 2;
+    h[order + k] = a[k] / 2;
+  }
+  return h;
+}
+
+// the integral of cos(m w) over [low, high]
+double cosine_integral(double m, double low, double high)
+{
+  if (m == 0) {
+    return high - low;
+  }
+  return (std::sin(m * high) - std::sin(m * low)) / m;
+}
+
+// A(w) = sum_k a[k] cos(k w) at x = cos(w), by Clenshaw's recurrence on
+// the Chebyshev polynomials T_k(x) = cos(k w)
+double cosine_series(const std::vector<double>& a, double x)
+{
+  double next = 0;
+  double after = 0;
+  for (size_t k = a.size(); k-- > 1;) {
+    const double current = 2 * x * next - after + a[k];
+    after = next;
+    next = current;
+  }
+  return x * next - after + a[0];
+}
+
+// cosine series coefficients of the least squares design
+std::vector<double> least_squares_series(size_t unknowns,
+                                         const std::vector<band_t>& bands)
+{
+  // normal equations Q a = b of the weighted squared error integral
+  std::vector<double> q(unknowns * unknowns);
+  std::vector<double> b(unknowns);
+  for (const auto& band : bands) {
+    const double low = M_PI * band.low;
+    const double high = M_PI * band.high;
+    for (size_t k = 0; k < unknowns; k++) {
+      const auto kk = static_cast<double>(k);
+      b[k] += band.weight * band.desired * cosine_integral(kk, low, high);
+      for (size_t l = 0; l <= k; l++) {
+        const auto ll = static_cast<double>(l);
+        q[k * unknowns + l] += band.weight / 2
+            * (cosine_integral(kk - ll, low, high)
+               + cosine_integral(kk + ll, low, high));
+      }
+    }
+  }
+
+  // Cholesky. Long filters with wide transition bands make Q nearly
+  // singular, so a tiny diagonal load keeps the factorization stable.
+  const double load = 1e-12 * q[0];
+  for (size_t k = 0; k < unknowns; k++) {
+    q[k * unknowns + k] += load;
+  }
+  for (size_t k = 0; k < unknowns; k++) {
+    for (size_t l = 0; l <= k; l++) {
+      double sum = q[k * unknowns + l];
+      for (size_t m = 0; m < l; m++) {
+        sum -= q[k * unknowns + m] * q[l * unknowns + m];
+      }
+      q[k * unknowns + l] =
+          k == l ? std::sqrt(std::max(sum, load)) : sum / q[l * unknowns + l];
+    }
+  }
+  std::vector<double> a(b);
+  for (size_t k = 0; k < unknowns; k++) {
+    for (size_t m = 0; m < k; m++) {
+      a[k] -= q[k * unknowns + m] * a[m];
+    }
+    a[k] /= q[k * unknowns + k];
+  }
+  for (size_t k = unknowns; k-- > 0;) {
+    for (size_t m = k + 1; m < unknowns; m++) {
+      a[k] -= q[m * unknowns + k] * a[m];
+    }
+    a[k] /= q[k * unknowns + k];
+  }
+  return a;
+}
+
+// Throws when no passband is left to fit: design_bands() drops a passband
+// the transition bands squeeze out, and a fit to the stopbands alone would
+// pass nothing.
+void check_bands(const std::vector<band_t>& bands)
+{
+  if (std::none_of(bands.begin(),
+                   bands.end(),
+                   [](const band_t& band) { return band.desired != 0; }))
+  {
+    throw std::invalid_argument(
+        "the passband is narrower than the transition band");
+  }
+}
+
+}  // namespace
+
+std::vector<band_t> fir_window::design_bands(const DesignSpec& spec)
+{
+  const double half = spec.transition / 2;
+  const double low = std::min(spec.lambda1, spec.lambda2);
+  const double high = std::max(spec.lambda1, spec.lambda2);
+  const double stop = spec.stopband_weight;
+
+  std::vector<band_t> bands;
+  switch (spec.filter_type) {
+    case LOWPASS:
+      bands = {{0, spec.lambda1 - half, 1, 1},
+               {spec.lambda1 + half, 1, 0, stop}};
+      break;
+    case HIGHPASS:
+      bands = {{0, spec.lambda1 - half, 0, stop},
+               {spec.lambda1 + half, 1, 1, 1}};
+      break;
+    case BANDPASS:
+      bands = {{0, low - half, 0, stop},
+               {low + half, high - half, 1, 1},
+               {high + half, 1, 0, stop}};
+      break;
+    case BANDSTOP:
+      bands = {{0, low - half, 1, 1},
+               {low + half, high - half, 0, stop},
+               {high + half, 1, 1, 1}};
+      break;
+    case MOVING_AVERAGE:
+      break;
+  }
+
+  std::vector<band_t> kept;
+  for (band_t band : bands) {
+    band.low = std::clamp(band.low, 0.0, 1.0);
+    band.high = std::clamp(band.high, 0.0, 1.0);
+    if (band.high > band.low) {
+      kept.push_back(band);
+    }
+  }
+  return kept;
+}
+
+std::vector<double> fir_window::design_equiripple(
+    size_t num_taps, const std::vector<band_t>& bands)
+{
+  if (num_taps % 2 == 0) {
+    throw std::invalid_argument("equiripple design needs an odd tap count");
+  }
+  check_bands(bands);
+  const size_t order = (num_taps - 1) / 2;
+  if (order == 0) {
+    // a single tap is a constant gain, with nothing to exchange
+    return taps_from_cosine_series(least_squares_series(1, bands));
+  }
+  const size_t unknowns = order + 1;  // cosine coefficients
+  const size_t extremals = unknowns + 1;
+
+  // dense grid over the bands, both edges of every band included
+  double total = 0;
+  for (const auto& band : bands) {
+    total += band.high - band.low;
+  }
+  const double spacing =
+      total / static_cast<double>(GRID_DENSITY * extremals);
+  std::vector<double> grid_x;
+  std::vector<double> desired;
+  std::vector<double> weight;
+  std::vector<size_t> band_of;
+  for (size_t b = 0; b < bands.size(); b++) {
+    const band_t& band = bands[b];
+    const auto points = std::max<size_t>(
+        1, static_cast<size_t>(std::ceil((band.high - band.low) / spacing)));
+    for (size_t i = 0; i <= points; i++) {
+      const double f = band.low
+          + (band.high - band.low) * static_cast<double>(i)
+              / static_cast<double>(points);
+      grid_x.push_back(std::cos(M_PI * f));
+      desired.push_back(band.desired);
+      weight.push_back(band.weight);
+      band_of.push_back(b);
+    }
+  }
+  const size_t grid_size = grid_x.size();
+
+  std::vector<size_t> extremal(extremals);
+  for (size_t k = 0; k < extremals; k++) {
+    extremal[k] = k * (grid_size - 1) / (extremals - 1);
+  }
+
+  std::vector<double> x(extremals);
+  std::vector<double> y(extremals);
+  std::vector<double> weights(unknowns);
+  std::vector<double> error(grid_size);
+  bool converged = false;
+  for (int iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+    for (size_t k = 0; k < extremals; k++) {
+      x[k] = grid_x[extremal[k]];
+    }
+    // levelled error delta over all extremals
+    double numerator = 0;
+    double denominator = 0;
+    double sign = 1;
+    for (size_t k = 0; k < extremals; k++) {
+      const double b = barycentric_weight(x, k, extremals);
+      numerator += b * desired[extremal[k]];
+      denominator += sign * b / weight[extremal[k]];
+      sign = -sign;
+    }
+    const double delta = numerator / denominator;
+
+    // the polynomial through the first unknowns extremals at +-delta
+    sign = 1;
+    for (size_t k = 0; k < unknowns; k++) {
+      y[k] = desired[extremal[k]] - sign * delta / weight[extremal[k]];
+      weights[k] = barycentric_weight(x, k, unknowns);
+      sign = -sign;
+    }
+    for (size_t i = 0; i < grid_size; i++) {
+      error[i] =
+          weight[i] * (desired[i] - interpolate(x, y, weights, grid_x[i]));
+    }
+
+    // local extrema of the error, band edges included
+    std::vector<size_t> found;
+    for (size_t i = 0; i < grid_size; i++) {
+      const bool has_left = i > 0 && band_of[i - 1] == band_of[i];
+      const bool has_right = i + 1 < grid_size && band_of[i + 1] == band_of[i];
+      const double e = error[i];
+      const bool peak = (!has_left || e >= error[i - 1])
+          && (!has_right || e > error[i + 1]) && e > 0;
+      const bool trough = (!has_left || e <= error[i - 1])
+          && (!has_right || e < error[i + 1]) && e < 0;
+      if (peak || trough) {
+        found.push_back(i);
+      }
+    }
+    // keep the errors alternating, the larger of each same-signed run
+    std::vector<size_t> alternating;
+    for (size_t i : found) {
+      if (!alternating.empty()
+          && (error[i] > 0) == (error[alternating.back()] > 0))
+      {
+        if (std::fabs(error[i]) > std::fabs(error[alternating.back()])) {
+          alternating.back() = i;
+        }
+        continue;
+      }
+      alternating.push_back(i);
+    }
+    while (alternating.size() > extremals) {
+      if (std::fabs(error[alternating.front()])
+          > std::fabs(error[alternating.back()]))
+      {
+        alternating.pop_back();
+      } else {
+        alternating.erase(alternating.begin());
+      }
+    }
+    if (alternating.size() < extremals) {
+      break;
+    }
+    extremal = alternating;
+
+    double largest = 0;
+    double smallest = HUGE_VAL;
+    for (size_t i : extremal) {
+      largest = std::max(largest, std::fabs(error[i]));
+      smallest = std::min(smallest, std::fabs(error[i]));
+    }
+    if (largest - smallest <= CONVERGENCE * largest) {
+      converged = true;
+      break;
+    }
+  }
+
+  // sample the final response at w_j = pi j / M and invert the cosine
+  // series with a type I DCT
+  std::vector<double> samples(unknowns);
+  for (size_t j = 0; j < unknowns; j++) {
+    samples[j] = interpolate(
+        x, y, weights, std::cos(M_PI * static_cast<double>(j) / order));
+  }
+  std::vector<double> a(unknowns);
+  for (size_t k = 0; k < unknowns; k++) {
+    double sum = 0;
+    for (size_t j = 0; j < unknowns; j++) {
+      const double end_weight = (j == 0 || j == order) ? 0.5 : 1.0;
+      sum += end_weight * samples[j]
+          * std::cos(M_PI * static_cast<double>(j * k % (2 * order)) / order);
+    }
+    a[k] = (k == 0 || k == order ? 1.0 : 2.0) * sum / order;
+  }
+
+  // When the optimal ripple approaches rounding level, which happens with
+  // many taps and wide transition bands, the exchange stalls. Keep
+  // whichever of its result and the least squares design has the smaller
+  // maximum error.
+  if (!converged) {
+    const std::vector<double> fallback = least_squares_series(unknowns, bands);
+    double exchange_error = 0;
+    double fallback_error = 0;
+    for (size_t i = 0; i < grid_size; i++) {
+      exchange_error = std::max(
+          exchange_error,
+          weight[i] * std::fabs(desired[i] - cosine_series(a, grid_x[i])));
+      fallback_error = std::max(
+          fallback_error,
+          weight[i]
+              * std::fabs(desired[i] - cosine_series(fallback, grid_x[i])));
+    }
+    if (fallback_error < exchange_error) {
+      a = fallback;
+    }
+  }
+  return taps_from_cosine_series(a);
+}
+
+std::vector<double> fir_window::design_least_squares(
+    size_t num_taps, const std::vector<band_t>& bands)
+{
+  if (num_taps % 2 == 0) {
+    throw std::invalid_argument("least squares design needs an odd tap count");
+  }
+  check_bands(bands);
+  return taps_from_cosine_series(
+      least_squares_series((num_taps - 1) / 2 + 1, bands));
+}
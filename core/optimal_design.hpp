@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "design.hpp"
+
+namespace fir_window
+{
+
+// One band of a piecewise constant target response. Edges are fractions
+// of Pi; the gaps between bands are transition bands left unconstrained.
+struct band_t
+{
+  double low;
+  double high;
+  double desired;  // 1 in a passband, 0 in a stopband
+  double weight;  // relative importance of the error in this band
+};
+
+// Bands for the filter type of spec: every cutoff becomes a transition
+// band spec.transition wide centred on it. Passbands have weight 1 and
+// stopbands spec.stopband_weight. Bands squeezed to nothing at 0 or 1 are
+// dropped.
+std::vector<band_t> design_bands(const DesignSpec& spec);
+
+// Parks-McClellan (Remez exchange) design of an odd-length linear-phase
+// filter minimizing the maximum weighted error over the bands. Returns
+// num_taps symmetric coefficients, the same layout as the window method.
+// Throws std::invalid_argument if no band is a passband.
+std::vector<double> design_equiripple(size_t num_taps,
+                                      const std::vector<band_t>& bands);
+
+// Odd-length linear-phase filter minimizing the integrated weighted
+// squared error over the bands, solved in closed form. Throws
+// std::invalid_argument if no band is a passband.
+std::vector<double> design_least_squares(size_t num_taps,
+                                         const std::vector<band_t>& bands);
+
+}  // namespace fir_window
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+
+#include "parallel_bank.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace
+{
+
+// slices shorter than this cost more to hand off than to compute
+constexpr size_t MIN_SLICE_TAPS = 128;
+
+// taps a helper sums between checks for cancellation
+constexpr size_t CHUNK_TAPS = 256;
+
+// doubles per cache line, so no two participants write the same line
+constexpr size_t LINE_DOUBLES = 8;
+
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+fir_window::ParallelBank::~ParallelBank()
+{
+  stop();
+}
+
+void fir_window::ParallelBank::stop()
+{
+  started.store(false);
+  stopping.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  stopping.store(false);
+  num_helpers = 0;
+}
+
+void fir_window::ParallelBank::attach(const FilterBank* filter_bank,
+                                      int64_t deadline_ns)
+{
+  stop();
+  bank = filter_bank;
+  deadline = deadline_ns;
+  missed.store(0);
+}
+
+void fir_window::ParallelBank::start(const FilterBank* filter_bank,
+                                     const std::vector<int>& cpus,
+                                     int64_t deadline_ns)
+{
+  attach(filter_bank, deadline_ns);
+  start(cpus);
+}
+
+void fir_window::ParallelBank::start(const std::vector<int>& cpus)
+{
+  if (bank == nullptr || started.load() || stopping.load()) {
+    return;
+  }
+  const size_t taps = bank->taps();
+  const size_t participants =
+      std::min(cpus.size() + 1, taps / MIN_SLICE_TAPS);
+  if (participants < 2) {
+    return;
+  }
+  num_helpers = participants - 1;
+  stride = (bank->paddedBands() + LINE_DOUBLES - 1) / LINE_DOUBLES
+      * LINE_DOUBLES;
+  // one row per participant plus one for slices computed inline, and the
+  // scratch rows they sum chunks in
+  partials.assign(2 * (participants + 1) * stride, 0.0);
+
+  const auto boundary = [taps, participants](size_t slice)
+  { return taps * slice / participants; };
+  own_last_tap = boundary(1);
+  jobs = std::make_unique<slot_t[]>(num_helpers);
+  period.store(0);
+  cancelled.store(0);
+  for (size_t helper = 0; helper < num_helpers; helper++) {
+    jobs[helper].first_tap = boundary(helper + 1);
+    jobs[helper].last_tap = boundary(helper + 2);
+  }
+
+  for (size_t helper = 0; helper < num_helpers; helper++) {
+    threads.emplace_back(&ParallelBank::helperLoop, this, helper);
+    const int cpu = cpus[helper];
+    if (cpu < 0) {
+      continue;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(threads.back().native_handle(), sizeof(set), &set);
+    // best effort: a spinning helper only gets real-time priority on a
+    // core of its own, where it cannot starve anything else
+    sched_param param {};
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    pthread_setschedparam(threads.back().native_handle(), SCHED_FIFO, &param);
+  }
+  // a helper told to stop in the meantime leaves at its first look
+  started.store(true, std::memory_order_release);
+}
+
+void fir_window::ParallelBank::helperLoop(size_t helper)
+{
+  slot_t& slot = jobs[helper];
+  double* partial = partials.data() + (helper + 1) * stride;
+  double* scratch = partial + (num_helpers + 2) * stride;
+  uint64_t seen = 0;
+  while (!stopping.load(std::memory_order_relaxed)) {
+    const uint64_t current = period.load(std::memory_order_acquire);
+    if (current == seen) {
+      cpu_relax();
+      continue;
+    }
+    seen = current;
+    // busy is raised before the first look at cancelled, so either the
+    // real-time thread sees the helper reading and waits for it, or the
+    // helper sees the cancellation and never touches the history
+    slot.busy.store(true);
+    const bool finished = sliceSums(
+        slot.first_tap, slot.last_tap, partial, scratch, current);
+    slot.busy.store(false);
+    if (finished) {
+      slot.done.store(current, std::memory_order_release);
+    }
+  }
+}
+
+bool fir_window::ParallelBank::sliceSums(size_t first_tap,
+                                         size_t last_tap,
+                                         double* partial,
+                                         double* scratch,
+                                         uint64_t job) const
+{
+  const size_t padded_bands = bank->paddedBands();
+  std::fill_n(partial, padded_bands, 0.0);
+  for (size_t first = first_tap; first < last_tap; first += CHUNK_TAPS) {
+    if (job != 0 && cancelled.load() >= job) {
+      return false;
+    }
+    bank->computeRange(first, std::min(first + CHUNK_TAPS, last_tap), scratch);
+    for (size_t band = 0; band < padded_bands; band++) {
+      partial[band] += scratch[band];
+    }
+  }
+  return true;
+}
+
+void fir_window::ParallelBank::compute(double* out)
+{
+  if (!started.load(std::memory_order_acquire)) {
+    bank->compute(out);
+    return;
+  }
+  using clock = std::chrono::steady_clock;
+  const auto expiry = clock::now() + std::chrono::nanoseconds(deadline);
+  const uint64_t current = period.load(std::memory_order_relaxed) + 1;
+  period.store(current, std::memory_order_release);
+
+  double* sum = partials.data();
+  double* inline_partial = partials.data() + (num_helpers + 1) * stride;
+  double* inline_scratch = inline_partial + (num_helpers + 2) * stride;
+  bank->computeRange(0, own_last_tap, sum);
+  bool late = false;
+  for (size_t helper = 0; helper < num_helpers; helper++) {
+    slot_t& slot = jobs[helper];
+    bool ready = slot.done.load(std::memory_order_acquire) == current;
+    while (!ready && clock::now() < expiry) {
+      cpu_relax();
+      ready = slot.done.load(std::memory_order_acquire) == current;
+    }
+    const double* partial = partials.data() + (helper + 1) * stride;
+    if (!ready) {
+      if (!late) {
+        cancelled.store(current);
+        late = true;
+      }
+      sliceSums(slot.first_tap,
+                slot.last_tap,
+                inline_partial,
+                inline_scratch,
+                0);
+      partial = inline_partial;
+      missed.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (size_t band = 0; band < bank->paddedBands(); band++) {
+      sum[band] += partial[band];
+    }
+  }
+  // a cancelled helper gives up at its next chunk boundary
+  for (size_t helper = 0; late && helper < num_helpers; helper++) {
+    while (jobs[helper].busy.load()) {
+      cpu_relax();
+    }
+  }
+  std::copy_n(sum, bank->bands(), out);
+}
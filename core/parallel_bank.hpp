@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "filter_bank.hpp"
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// Spreads FilterBank::compute() over a pool of spinning helper threads.
+//
+// The taps are cut into one contiguous slice per participant. The
+// real-time thread keeps slice 0 and publishes a new period number; every
+// helper, pinned to its own core and spinning on that number, computes
+// the partial sums of its slice for all bands and stamps its job slot with
+// the period. The real-time thread then waits for the stamps up to a
+// deadline. A helper that is late has its slice computed inline instead
+// and is counted as a missed deadline. It is also told to give up: helpers
+// work through their slice CHUNK_TAPS taps at a time and check for that
+// between chunks, and compute() waits until every late helper has left the
+// history before it returns, so the next push() never races with one.
+// Helpers and the inline fallback sum the same chunks in the same order,
+// and partials are always added in slice order, so the output does not
+// depend on who computed which slice.
+//
+// Each helper occupies its core completely while started. Stop the pool
+// before the bank is resized or redesigned.
+class ParallelBank
+{
+public:
+  ParallelBank() = default;
+  ~ParallelBank();
+  ParallelBank(const ParallelBank&) = delete;
+  ParallelBank& operator=(const ParallelBank&) = delete;
+
+  // Sets the bank compute() works on; until start(), compute() runs it
+  // inline. bank must stay configured and alive until stop().
+  void attach(const FilterBank* bank, int64_t deadline_ns);
+
+  // Starts one helper per entry of cpus for the attached bank, pinned to
+  // that cpu (-1 leaves it unpinned). With no cpus, or fewer taps than
+  // participants, compute() keeps running inline. May run on another
+  // thread while the real-time thread calls compute(), which takes the
+  // helpers on from its next call; does nothing once started or after
+  // requestStop().
+  void start(const std::vector<int>& cpus);
+
+  // attach() and start() in one, for a pool nothing computes with yet
+  void start(const FilterBank* bank,
+             const std::vector<int>& cpus,
+             int64_t deadline_ns);
+  void stop();
+  // Tells the helpers to leave without waiting for them; safe on the
+  // real-time thread. Call compute() no more, and stop() or destroy the
+  // pool from another thread to join them.
+  void requestStop() { stopping.store(true); }
+
+  // RT side: writes bank->bands() outputs for the current history
+  void compute(double* out);
+
+  size_t helpers() const
+  {
+    return started.load(std::memory_order_acquire) ? num_helpers : 0;
+  }
+  uint64_t missedDeadlines() const { return missed.load(); }
+
+private:
+  // a helper's job slot, one cache line of control per helper
+  struct alignas(64) slot_t
+  {
+    std::atomic<uint64_t> done {0};
+    std::atomic<bool> busy {false};  // reading the history
+    size_t first_tap = 0;
+    size_t last_tap = 0;
+  };
+
+  void helperLoop(size_t helper);
+  // partial sums of a slice, chunk by chunk into scratch; false if the
+  // job (0 for none) was cancelled
+  bool sliceSums(size_t first_tap,
+                 size_t last_tap,
+                 double* partial,
+                 double* scratch,
+                 uint64_t job) const;
+
+  const FilterBank* bank = nullptr;
+  int64_t deadline = 0;
+  size_t stride = 0;  // partial sums per participant, cache line padded
+  size_t own_last_tap = 0;
+
+  alignas(64) std::atomic<uint64_t> period {0};
+  // the last period whose late helpers must abandon their slice
+  alignas(64) std::atomic<uint64_t> cancelled {0};
+  alignas(64) std::atomic<bool> stopping {false};
+  // set once the helpers and everything compute() needs for them are ready
+  std::atomic<bool> started {false};
+  std::atomic<uint64_t> missed {0};
+
+  size_t num_helpers = 0;
+  std::unique_ptr<slot_t[]> jobs;
+  // a row of partial sums per participant, then one for inline fallbacks,
+  // then as many rows of chunk scratch
+  rt_vector<double> partials;
+  std::vector<std::thread> threads;
+};
+
+}  // namespace fir_window
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <numeric>
+
+#include "partitioned_convolver.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+fir_window::PartitionedConvolver::PartitionedConvolver()
+{
+  for (auto& slot : ready) {
+    slot.store(0);
+  }
+  sem_init(&wakeup, 0, 0);
+}
+
+fir_window::PartitionedConvolver::~PartitionedConvolver()
+{
+  stop();
+  sem_destroy(&wakeup);
+}
+
+void fir_window::PartitionedConvolver::stop()
+{
+  if (!worker.joinable()) {
+    return;
+  }
+  stopping.store(true);
+  sem_post(&wakeup);
+  worker.join();
+}
+
+void fir_window::PartitionedConvolver::configure(const double* h,
+                                                 size_t num_taps,
+                                                 size_t head_taps)
+{
+  stop();
+
+  const size_t partition = FftPlan::sizeFor(std::max<size_t>(head_taps, 2) / 2);
+  head_length = std::min(2 * partition, num_taps);
+  head.resize(head_length);
+  for (size_t i = 0; i < head_length; i++) {
+    head[i] = h[head_length - 1 - i];
+  }
+
+  samples = 0;
+  tail_valid = false;
+  prime_pending.store(false);
+  completed.store(0);
+  missed.store(0);
+  for (auto& slot : ready) {
+    slot.store(0);
+  }
+
+  const size_t tail_taps = num_taps - head_length;
+  num_partitions = (tail_taps + partition - 1) / partition;
+  if (num_partitions == 0) {
+    block_size = 0;
+    history.resize(head_length);
+    return;
+  }
+
+  block_size = partition;
+  const size_t bins = block_size + 1;
+  plan = FftPlan(2 * block_size);
+  spectrum.assign(2 * block_size, 0.0);
+  partitions.assign(num_partitions * bins, 0.0);
+  for (size_t p = 0; p < num_partitions; p++) {
+    std::fill(spectrum.begin(), spectrum.end(), 0.0);
+    for (size_t i = 0; i < block_size; i++) {
+      const size_t tap = head_length + p * block_size + i;
+      if (tap < num_taps) {
+        spectrum[i] = h[tap];
+      }
+    }
+    plan.forward(spectrum.data());
+    std::copy_n(spectrum.begin(), bins, partitions.begin() + p * bins);
+  }
+
+  input_ring.assign(RING_BLOCKS * block_size, 0.0);
+  output_ring.assign(RING_BLOCKS * block_size, 0.0);
+  previous_input.assign(block_size, 0.0);
+  accumulator.assign(bins, 0.0);
+  spectra.assign(num_partitions * bins, 0.0);
+  spectra_pos = num_partitions - 1;
+  history.resize(head_length + (num_partitions + 1) * block_size);
+  prime_input.assign((num_partitions + 1) * block_size, 0.0);
+
+  while (sem_trywait(&wakeup) == 0) {
+  }
+  stopping.store(false);
+  worker = std::thread(&PartitionedConvolver::workerLoop, this);
+  // best effort: run the helper above normal threads but below RTXI
+  sched_param param {};
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+  pthread_setschedparam(worker.native_handle(), SCHED_FIFO, &param);
+}
+
+double fir_window::PartitionedConvolver::process(double input)
+{
+  history.push(input);
+  double out = std::inner_product(head.begin(),
+                                  head.end(),
+                                  history.data() + history.length()
+                                      - head_length,
+                                  0.0);
+  if (block_size == 0) {
+    return out;
+  }
+
+  const size_t pos = samples & (block_size - 1);
+  const uint64_t block = samples / block_size;
+  if (pos == 0) {
+    // the tail for this block was computed from input up to block - 2
+    tail_valid = false;
+    if (block >= 2) {
+      const size_t slot = (block - 2) % RING_BLOCKS;
+      if (ready[slot].load(std::memory_order_acquire) == block - 1) {
+        tail_valid = true;
+        tail_block = output_ring.data() + slot * block_size;
+      } else {
+        missed.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  if (tail_valid) {
+    out += tail_block[pos];
+  }
+
+  input_ring[(block % RING_BLOCKS) * block_size + pos] = input;
+  samples++;
+  if (pos == block_size - 1) {
+    completed.store(block + 1, std::memory_order_release);
+    sem_post(&wakeup);
+  }
+  return out;
+}
+
+void fir_window::PartitionedConvolver::copyHistory(
+    const PartitionedConvolver& other)
+{
+  if (other.head_length != head_length || other.block_size != block_size
+      || other.num_partitions != num_partitions
+      || other.history.length() != history.length())
+  {
+    return;
+  }
+  history.copyFrom(other.history);
+  if (block_size == 0) {
+    return;
+  }
+
+  samples = other.samples;
+  const uint64_t block = samples / block_size;
+  const size_t pos = samples & (block_size - 1);
+  std::copy(other.input_ring.begin(),
+            other.input_ring.end(),
+            input_ring.begin());
+
+  // The old helper's outputs for this block and the next, if it had them:
+  // their input is already gone from its ring. A stamped slot is never
+  // written again, since the old convolver gets no more input.
+  for (uint64_t source = std::max<uint64_t>(block, 2) - 2; source < block;
+       source++)
+  {
+    const size_t slot = source % RING_BLOCKS;
+    if (other.ready[slot].load(std::memory_order_acquire) != source + 1) {
+      continue;
+    }
+    std::copy_n(other.output_ring.begin() + slot * block_size,
+                block_size,
+                output_ring.begin() + slot * block_size);
+    ready[slot].store(source + 1, std::memory_order_relaxed);
+  }
+  tail_valid = other.tail_valid && pos > 0;
+  if (tail_valid) {
+    tail_block = output_ring.data() + ((block - 2) % RING_BLOCKS) * block_size;
+  }
+
+  // everything before this block, for the new helper's delay line
+  std::copy_n(history.data() + history.length() - pos - prime_input.size(),
+              prime_input.size(),
+              prime_input.begin());
+  prime_block = block;
+  completed.store(block, std::memory_order_relaxed);
+  prime_pending.store(true, std::memory_order_release);
+  sem_post(&wakeup);
+}
+
+void fir_window::PartitionedConvolver::workerLoop()
+{
+  uint64_t next = 0;
+  for (;;) {
+    sem_wait(&wakeup);
+    if (stopping.load()) {
+      return;
+    }
+    if (prime_pending.exchange(false, std::memory_order_acquire)) {
+      prime();
+      next = prime_block;
+    }
+    const uint64_t done = completed.load(std::memory_order_acquire);
+    for (; next < done; next++) {
+      if (done - next < RING_BLOCKS && computeTail(next)) {
+        continue;
+      }
+      // so far behind that the real-time thread has reused this block's
+      // input slot, before or while it was read; keep the delay line
+      // aligned with silence instead
+      std::fill(previous_input.begin(), previous_input.end(), 0.0);
+      spectra_pos = (spectra_pos + 1) % num_partitions;
+      const size_t bins = block_size + 1;
+      std::fill_n(spectra.begin() + spectra_pos * bins, bins, 0.0);
+    }
+  }
+}
+
+bool fir_window::PartitionedConvolver::computeTail(uint64_t block)
+{
+  const double* input =
+      input_ring.data() + (block % RING_BLOCKS) * block_size;
+
+  // The real-time thread starts overwriting this slot as soon as it has
+  // completed block + RING_BLOCKS - 1, so the copy only counts if that had
+  // not happened once it was taken.
+  std::copy(input, input + block_size, spectrum.begin() + block_size);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (completed.load(std::memory_order_relaxed) - block >= RING_BLOCKS) {
+    return false;
+  }
+
+  pushSpectrum();
+  accumulateTail(block);
+  return true;
+}
+
+void fir_window::PartitionedConvolver::pushSpectrum()
+{
+  // overlap-save: transform the previous and the current block together
+  std::copy(previous_input.begin(), previous_input.end(), spectrum.begin());
+  for (size_t i = 0; i < block_size; i++) {
+    previous_input[i] = spectrum[block_size + i].real();
+  }
+  plan.forward(spectrum.data());
+
+  const size_t bins = block_size + 1;
+  spectra_pos = (spectra_pos + 1) % num_partitions;
+  std::copy_n(spectrum.begin(), bins, spectra.begin() + spectra_pos * bins);
+}
+
+void fir_window::PartitionedConvolver::accumulateTail(uint64_t block)
+{
+  const size_t bins = block_size + 1;
+  // frequency-domain delay line: partition p meets the block p periods ago
+  std::fill(accumulator.begin(), accumulator.end(), 0.0);
+  for (size_t p = 0; p < num_partitions; p++) {
+    const size_t age = (spectra_pos + num_partitions - p) % num_partitions;
+    const std::complex<double>* x = spectra.data() + age * bins;
+    const std::complex<double>* g = partitions.data() + p * bins;
+    for (size_t k = 0; k < bins; k++) {
+      accumulator[k] += x[k] * g[k];
+    }
+  }
+
+  // real signals: rebuild the upper half of the spectrum by symmetry
+  for (size_t k = 0; k < bins; k++) {
+    spectrum[k] = accumulator[k];
+  }
+  for (size_t k = 1; k < block_size; k++) {
+    spectrum[2 * block_size - k] = std::conj(accumulator[k]);
+  }
+  plan.inverse(spectrum.data());
+
+  const size_t slot = block % RING_BLOCKS;
+  double* output = output_ring.data() + slot * block_size;
+  for (size_t i = 0; i < block_size; i++) {
+    output[i] = spectrum[block_size + i].real();
+  }
+  ready[slot].store(block + 1, std::memory_order_release);
+}
+
+// The last num_partitions blocks before prime_block go through the delay
+// line as if they had been computed here. The tail of the block just
+// before it is only computed if the old helper had not delivered it.
+void fir_window::PartitionedConvolver::prime()
+{
+  const double* input = prime_input.data();
+  std::copy_n(input, block_size, previous_input.begin());
+  for (size_t b = 1; b <= num_partitions; b++) {
+    const double* block = input + b * block_size;
+    std::copy(block, block + block_size, spectrum.begin() + block_size);
+    pushSpectrum();
+  }
+  if (prime_block == 0) {
+    return;
+  }
+  const uint64_t last = prime_block - 1;
+  if (ready[last % RING_BLOCKS].load(std::memory_order_acquire) != last + 1) {
+    accumulateTail(last);
+  }
+}
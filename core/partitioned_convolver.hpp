@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "delay_line.hpp"
+#include "fft.hpp"
+#include "rt_memory.hpp"
+
+#include <semaphore.h>
+
+namespace fir_window
+{
+
+// Zero-latency convolution for long filters.
+//
+// The impulse response is split in two. The first head_taps() taps run as
+// a direct dot product inside process(), so the output for a sample is
+// available in the same period. The remaining taps are cut into uniform
+// partitions of B = head_taps() / 2 samples and convolved by FFT
+// (overlap-save with a frequency-domain delay line) on a helper thread.
+//
+// Because the tail starts 2B taps into the filter, its contribution to
+// block m depends only on input up to block m - 2. The helper is woken
+// when a block of input is complete and has one block period to hand the
+// partial sums back through a lock-free slot ring. A slot that is not
+// ready when the real-time thread needs it counts as a missed deadline
+// and that block's tail contribution is dropped.
+//
+// copyHistory() hands the input history of a running convolver to one of
+// the same geometry, so a retune does not refill the filter: the head
+// switches to the new taps at once, and the tail after the two blocks the
+// old helper had already computed. The new helper rebuilds its
+// frequency-domain delay line from the handed-over input.
+class PartitionedConvolver
+{
+public:
+  PartitionedConvolver();
+  ~PartitionedConvolver();
+  PartitionedConvolver(const PartitionedConvolver&) = delete;
+  PartitionedConvolver& operator=(const PartitionedConvolver&) = delete;
+
+  // h[0] applies to the newest sample. head_taps is rounded up to twice
+  // a power of two. Starts the helper thread when there is a tail.
+  void configure(const double* h, size_t num_taps, size_t head_taps);
+
+  // RT side: one sample in, one sample out
+  double process(double input);
+
+  // RT side: takes over the input history, block position and pending
+  // tail outputs of other if it has the same number of taps and head; does
+  // nothing otherwise. Call before the first process(), while other is no
+  // longer processing. O(taps), no allocation.
+  void copyHistory(const PartitionedConvolver& other);
+
+  size_t headTaps() const { return head_length; }
+  uint64_t missedDeadlines() const { return missed.load(); }
+
+private:
+  static constexpr size_t RING_BLOCKS = 4;
+
+  void stop();
+  void workerLoop();
+  // false, with nothing changed, if the block's input was overwritten
+  bool computeTail(uint64_t block);
+  // transforms previous_input and the block in the upper half of spectrum
+  // into the next slot of the frequency-domain delay line
+  void pushSpectrum();
+  // the tail output for block from the delay line, into its output slot
+  void accumulateTail(uint64_t block);
+  // rebuilds the delay line from prime_input after copyHistory()
+  void prime();
+
+  // head, real-time thread only
+  size_t head_length = 0;
+  rt_vector<double> head;  // time reversed
+  // the head's input and, with a tail, the num_partitions + 1 blocks
+  // before it that copyHistory() needs
+  DelayLine history;
+
+  // tail geometry
+  size_t block_size = 0;
+  size_t num_partitions = 0;
+  FftPlan plan;
+  rt_vector<std::complex<double>> partitions;  // num_partitions x 2B
+
+  // real-time thread -> helper: input samples and completed block count
+  rt_vector<double> input_ring;  // RING_BLOCKS x B
+  std::atomic<uint64_t> completed {0};
+  uint64_t samples = 0;
+  bool tail_valid = false;
+  const double* tail_block = nullptr;
+
+  // real-time thread -> helper after copyHistory(): the num_partitions + 1
+  // blocks of input before block prime_block
+  rt_vector<double> prime_input;
+  uint64_t prime_block = 0;
+  std::atomic<bool> prime_pending {false};
+
+  // helper -> real-time thread: tail outputs, stamped with block + 1
+  rt_vector<double> output_ring;  // RING_BLOCKS x B
+  std::atomic<uint64_t> ready[RING_BLOCKS];
+  std::atomic<uint64_t> missed {0};
+
+  // helper thread only
+  rt_vector<double> previous_input;
+  rt_vector<std::complex<double>> spectrum;
+  rt_vector<std::complex<double>> accumulator;
+  rt_vector<std::complex<double>> spectra;  // num_partitions x (B + 1)
+  size_t spectra_pos = 0;
+
+  std::thread worker;
+  sem_t wakeup;
+  std::atomic<bool> stopping {false};
+};
+
+}  // namespace fir_window
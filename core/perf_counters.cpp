@@ -0,0 +1,268 @@
+#include <cmath>
+
+#include "perf_counters.hpp"
+
+#include <atomic>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+
+using fir_window::PerfCounters;
+
+struct event_config_t
+{
+  uint32_t type;
+  uint64_t config;
+  const char* name;
+};
+
+constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result)
+{
+  return cache | (op << 8) | (result << 16);
+}
+
+constexpr event_config_t EVENTS[PerfCounters::NUM_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HW_CACHE,
+     cache_event(PERF_COUNT_HW_CACHE_L1D,
+                 PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS),
+     "L1D misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "LLC misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch misses"},
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+constexpr bool USER_READS = true;
+
+inline uint64_t read_pmc(uint32_t counter)
+{
+  return __builtin_ia32_rdpmc(static_cast<int>(counter));
+}
+
+inline uint64_t read_tsc()
+{
+  return __builtin_ia32_rdtsc();
+}
+#else
+constexpr bool USER_READS = false;
+
+inline uint64_t read_pmc(uint32_t)
+{
+  return 0;
+}
+
+inline uint64_t read_tsc()
+{
+  return 0;
+}
+#endif
+
+// keeps the compiler from moving page reads across the sequence checks
+inline void compiler_barrier()
+{
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+int open_event(const event_config_t& event, pid_t tid, int group_fd)
+{
+  perf_event_attr attr {};
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  // the leader starts disabled and the members follow it
+  attr.disabled = group_fd < 0 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(SYS_perf_event_open,
+                                  &attr,
+                                  tid,
+                                  -1,  // any cpu
+                                  group_fd,
+                                  PERF_FLAG_FD_CLOEXEC));
+}
+
+}  // namespace
+
+fir_window::PerfCounters::~PerfCounters()
+{
+  close();
+}
+
+size_t fir_window::PerfCounters::open(pid_t tid)
+{
+  close();
+  if (!USER_READS) {
+    return 0;
+  }
+  page_bytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t num_open = 0;
+  for (size_t event = 0; event < NUM_EVENTS; event++) {
+    const int fd = open_event(EVENTS[event], tid, group_fd);
+    if (fd < 0) {
+      continue;
+    }
+    // the first page holds the index and offset rdpmc reads need
+    void* page = mmap(nullptr, page_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (page == MAP_FAILED) {
+      ::close(fd);
+      continue;
+    }
+    if (group_fd < 0) {
+      group_fd = fd;
+    }
+    fds[event] = fd;
+    pages[event] = static_cast<const volatile perf_event_mmap_page*>(page);
+    num_open++;
+  }
+  if (group_fd >= 0) {
+    ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+  reset();
+  return num_open;
+}
+
+void fir_window::PerfCounters::close()
+{
+  // members first, the leader owns the group
+  for (size_t event = NUM_EVENTS; event-- > 0;) {
+    if (pages[event] != nullptr) {
+      munmap(const_cast<perf_event_mmap_page*>(pages[event]), page_bytes);
+      pages[event] = nullptr;
+    }
+    if (fds[event] >= 0 && fds[event] != group_fd) {
+      ::close(fds[event]);
+    }
+    fds[event] = -1;
+  }
+  if (group_fd >= 0) {
+    ::close(group_fd);
+    group_fd = -1;
+  }
+  started = false;
+}
+
+// The sequence from the perf_event_mmap_page documentation: the page is
+// re-read until its lock count is unchanged, the live counter is added to
+// the offset, and the time since the page was last updated is derived from
+// the time stamp counter.
+bool fir_window::PerfCounters::read(
+    std::array<reading_t, NUM_EVENTS>& readings) const
+{
+  for (size_t event = 0; event < NUM_EVENTS; event++) {
+    const volatile perf_event_mmap_page* page = pages[event];
+    if (page == nullptr) {
+      continue;
+    }
+    reading_t& reading = readings[event];
+    uint32_t sequence = 0;
+    uint64_t cycles = 0;
+    uint64_t time_offset = 0;
+    uint32_t time_mult = 0;
+    uint16_t time_shift = 0;
+    bool user_time = false;
+    do {
+      sequence = page->lock;
+      compiler_barrier();
+      reading.time_enabled = page->time_enabled;
+      reading.time_running = page->time_running;
+      user_time = page->cap_user_time != 0;
+      if (user_time) {
+        cycles = read_tsc();
+        time_offset = page->time_offset;
+        time_mult = page->time_mult;
+        time_shift = page->time_shift;
+        if (page->cap_user_time_short != 0) {
+          cycles = page->time_cycles
+              + ((cycles - page->time_cycles) & page->time_mask);
+        }
+      }
+      const uint32_t index = page->index;
+      if (page->cap_user_rdpmc == 0 || index == 0) {
+        // not on the PMU at the moment, or no user-space access
+        return false;
+      }
+      const unsigned shift = 64U - page->pmc_width;
+      // the counter is pmc_width bits wide and sign extended
+      const auto pmc =
+          static_cast<int64_t>(read_pmc(index - 1) << shift) >> shift;
+      reading.count = page->offset + static_cast<uint64_t>(pmc);
+      compiler_barrier();
+    } while (page->lock != sequence);
+    if (user_time) {
+      const uint64_t quotient = cycles >> time_shift;
+      const uint64_t remainder =
+          cycles & ((uint64_t {1} << time_shift) - 1);
+      const uint64_t delta = time_offset + quotient * time_mult
+          + ((remainder * time_mult) >> time_shift);
+      reading.time_enabled += delta;
+      reading.time_running += delta;
+    }
+  }
+  return true;
+}
+
+void fir_window::PerfCounters::begin()
+{
+  started = read(start);
+}
+
+void fir_window::PerfCounters::end()
+{
+  std::array<reading_t, NUM_EVENTS> now;
+  if (!started || !read(now)) {
+    started = false;
+    return;
+  }
+  started = false;
+  for (size_t event = 0; event < NUM_EVENTS; event++) {
+    if (pages[event] == nullptr) {
+      continue;
+    }
+    const uint64_t enabled =
+        now[event].time_enabled - start[event].time_enabled;
+    const uint64_t running =
+        now[event].time_running - start[event].time_running;
+    if (running == 0 && enabled != 0) {
+      // the group never got onto the PMU during the interval
+      return;
+    }
+  }
+  for (size_t event = 0; event < NUM_EVENTS; event++) {
+    if (pages[event] == nullptr) {
+      continue;
+    }
+    const uint64_t enabled =
+        now[event].time_enabled - start[event].time_enabled;
+    const uint64_t running =
+        now[event].time_running - start[event].time_running;
+    const uint64_t delta = now[event].count - start[event].count;
+    // extrapolate if the kernel multiplexed the group with other events
+    const double scale = running < enabled
+        ? static_cast<double>(enabled) / static_cast<double>(running)
+        : 1.0;
+    sums[event] += scale == 1.0 ? delta
+                                : static_cast<uint64_t>(std::llround(
+                                    static_cast<double>(delta) * scale));
+  }
+  num_intervals++;
+}
+
+void fir_window::PerfCounters::reset()
+{
+  sums.fill(0);
+  num_intervals = 0;
+}
+
+const char* fir_window::PerfCounters::name(event_t event)
+{
+  return event < NUM_EVENTS ? EVENTS[event].name : "";
+}
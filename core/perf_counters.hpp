@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/perf_event.h>
+#include <sys/types.h>
+
+namespace fir_window
+{
+
+// Hardware performance counters of one thread, read around a region of
+// code through Linux perf_event_open(2).
+//
+// The counters form one event group, so they are scheduled onto the PMU
+// together. open() may run on any thread for the thread being measured;
+// every event is memory-mapped, and begin() and end(), called on the
+// measured thread, read the counts with the rdpmc instruction through the
+// mapped page, without a system call. end() adds the counts since begin()
+// to running totals, scaled up if the kernel had to multiplex the group;
+// an interval in which an event could not be read in user space is
+// skipped. Neither allocates, so both are safe to call from the real-time
+// thread once open() has run.
+//
+// Only user-space events are counted, which perf_event_paranoid 2 (the
+// default on most distributions) allows without privileges. Events the CPU
+// or a virtual machine does not provide are left out of the group and
+// report as unavailable. User-space reads need x86 and rdpmc enabled
+// (/sys/bus/event_source/devices/cpu/rdpmc, 1 by default); elsewhere
+// open() finds nothing to count.
+class PerfCounters
+{
+public:
+  enum event_t : size_t
+  {
+    CYCLES = 0,
+    INSTRUCTIONS,
+    L1D_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    NUM_EVENTS
+  };
+
+  using counts_t = std::array<uint64_t, NUM_EVENTS>;
+
+  PerfCounters() = default;
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Opens the group for thread tid (0 for the calling thread) and clears
+  // the totals. Returns the number of events opened, 0 if counters are
+  // unavailable here.
+  size_t open(pid_t tid = 0);
+  void close();
+  bool isOpen() const { return group_fd >= 0; }
+  bool available(event_t event) const { return pages[event] != nullptr; }
+
+  // measured thread only
+  void begin();
+  void end();
+
+  // sums over every begin()/end() interval since open() or reset()
+  const counts_t& totals() const { return sums; }
+  uint64_t intervals() const { return num_intervals; }
+  void reset();
+
+  static const char* name(event_t event);
+
+private:
+  // one event as read from its page, times in ns
+  struct reading_t
+  {
+    uint64_t count;
+    uint64_t time_enabled;
+    uint64_t time_running;
+  };
+
+  // false if any open event is not readable from user space right now
+  bool read(std::array<reading_t, NUM_EVENTS>& readings) const;
+
+  int group_fd = -1;
+  std::array<int, NUM_EVENTS> fds {-1, -1, -1, -1, -1};
+  // mapped perf_event_mmap_page of each event, null if not opened
+  std::array<const volatile perf_event_mmap_page*, NUM_EVENTS> pages {};
+  size_t page_bytes = 0;
+
+  std::array<reading_t, NUM_EVENTS> start {};
+  bool started = false;
+  counts_t sums {};
+  uint64_t num_intervals = 0;
+};
+
+}  // namespace fir_window
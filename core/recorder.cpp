@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "recorder.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+// the writer wakes up this often and writes once a batch is full
+constexpr auto WRITER_POLL = std::chrono::milliseconds(20);
+constexpr size_t STAGING_BYTES = size_t {1} << 20;
+
+size_t next_power_of_two(size_t value)
+{
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+}  // namespace
+
+fir_window::Recorder::Recorder(size_t frame_bytes, size_t capacity_frames)
+    : frame_size(frame_bytes)
+    , capacity(next_power_of_two(capacity_frames))
+{
+}
+
+fir_window::Recorder::~Recorder()
+{
+  stop();
+  std::free(staging);
+}
+
+bool fir_window::Recorder::start(const std::string& path,
+                                 const void* header,
+                                 size_t header_bytes,
+                                 bool direct_io)
+{
+  stop();
+  if (header_bytes > HEADER_BYTES) {
+    return false;
+  }
+  // the buffers are only allocated, and the ring only locked, once this
+  // instance records; they are kept for later recordings since push() may
+  // still be running on the real-time thread after stop()
+  if (staging == nullptr) {
+    // leave room for one frame beyond a full batch so a frame never has
+    // to be split between two flushes
+    staging_size = STAGING_BYTES + frame_size;
+    staging_size =
+        (staging_size + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES;
+    staging = static_cast<unsigned char*>(
+        std::aligned_alloc(BLOCK_BYTES, staging_size));
+    if (staging == nullptr) {
+      return false;
+    }
+  }
+  if (ring.empty()) {
+    try {
+      ring.resize(capacity * frame_size);
+    } catch (const std::bad_alloc&) {
+      return false;
+    }
+  }
+
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  direct = false;
+  fd = -1;
+  if (direct_io) {
+    // not every filesystem supports O_DIRECT, fall back to buffered writes
+    fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+    direct = fd >= 0;
+  }
+  if (fd < 0) {
+    fd = ::open(path.c_str(), flags, 0644);
+  }
+  if (fd < 0) {
+    return false;
+  }
+
+  std::memset(staging, 0, HEADER_BYTES);
+  std::memcpy(staging, header, header_bytes);
+  staging_fill = HEADER_BYTES;
+  head.store(0);
+  tail.store(0);
+  dropped_frames.store(0);
+  written_bytes.store(0);
+  write_failed.store(false);
+  stopping.store(false);
+  writer = std::thread(&Recorder::writerLoop, this);
+  recording.store(true, std::memory_order_release);
+  return true;
+}
+
+void fir_window::Recorder::stop()
+{
+  recording.store(false, std::memory_order_release);
+  if (!writer.joinable()) {
+    return;
+  }
+  stopping.store(true);
+  writer.join();
+  ::close(fd);
+  fd = -1;
+}
+
+void fir_window::Recorder::push(const void* frames, size_t count)
+{
+  const uint64_t position = head.load(std::memory_order_relaxed);
+  if (position + count - tail.load(std::memory_order_acquire) > capacity) {
+    dropped_frames.fetch_add(count, std::memory_order_relaxed);
+    return;
+  }
+  const auto* frame = static_cast<const unsigned char*>(frames);
+  for (size_t i = 0; i < count; i++) {
+    unsigned char* slot =
+        ring.data() + ((position + i) & (capacity - 1)) * frame_size;
+    std::memcpy(slot, frame + i * frame_size, frame_size);
+  }
+  head.store(position + count, std::memory_order_release);
+}
+
+void fir_window::Recorder::writerLoop()
+{
+  for (;;) {
+    const bool last_pass = stopping.load();
+    uint64_t position = tail.load(std::memory_order_relaxed);
+    const uint64_t end = head.load(std::memory_order_acquire);
+    while (position != end) {
+      std::memcpy(staging + staging_fill,
+                  ring.data() + (position & (capacity - 1)) * frame_size,
+                  frame_size);
+      staging_fill += frame_size;
+      tail.store(++position, std::memory_order_release);
+      if (staging_fill >= STAGING_BYTES && !flushStaging(false)) {
+        // push() stops queueing; stop() still joins and closes
+        recording.store(false, std::memory_order_release);
+        return;
+      }
+    }
+    if (last_pass) {
+      flushStaging(true);
+      return;
+    }
+    std::this_thread::sleep_for(WRITER_POLL);
+  }
+}
+
+bool fir_window::Recorder::flushStaging(bool final)
+{
+  // O_DIRECT needs whole aligned blocks; the remainder stays staged until
+  // more frames arrive or the recording ends
+  size_t bytes = staging_fill;
+  if (direct && !final) {
+    bytes -= bytes % BLOCK_BYTES;
+  }
+  if (direct && final && bytes % BLOCK_BYTES != 0) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_DIRECT);
+  }
+
+  size_t done = 0;
+  while (done < bytes) {
+    const ssize_t result = ::write(fd, staging + done, bytes - done);
+    if (result <= 0) {
+      write_failed.store(true);
+      return false;
+    }
+    done += static_cast<size_t>(result);
+  }
+  written_bytes.fetch_add(done);
+  std::memmove(staging, staging + done, staging_fill - done);
+  staging_fill -= done;
+  return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "rt_memory.hpp"
+
+namespace fir_window
+{
+
+// Streams fixed-size frames from the real-time thread to disk.
+//
+// push() is wait-free: it copies frames into a preallocated
+// single-producer/single-consumer ring and never touches the file. A
+// background writer drains the ring in large sequential writes. When the
+// ring is full the frames are dropped and counted instead of blocking. If
+// a write fails the writer stops and active() turns false.
+//
+// File layout: the header passed to start(), zero padded to HEADER_BYTES,
+// followed by the raw frames in the order they were pushed.
+class Recorder
+{
+public:
+  static constexpr size_t HEADER_BYTES = 4096;
+  static constexpr size_t BLOCK_BYTES = 4096;
+
+  Recorder(size_t frame_bytes, size_t capacity_frames);
+  ~Recorder();
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+
+  // non-RT: opens the file, writes the header and starts the writer. The
+  // first call allocates the ring.
+  bool start(const std::string& path,
+             const void* header,
+             size_t header_bytes,
+             bool direct_io);
+  // non-RT: stops accepting frames, flushes everything queued and closes
+  void stop();
+
+  // RT side
+  bool active() const { return recording.load(std::memory_order_acquire); }
+  // count consecutive frames, all queued or all dropped
+  void push(const void* frames, size_t count = 1);
+
+  uint64_t dropped() const { return dropped_frames.load(); }
+  uint64_t written() const { return written_bytes.load(); }
+  bool failed() const { return write_failed.load(); }
+
+private:
+  void writerLoop();
+  bool flushStaging(bool final);
+
+  size_t frame_size;
+  size_t capacity;  // frames, power of two
+  rt_vector<unsigned char> ring;
+  std::atomic<uint64_t> head {0};  // frames pushed, owned by the RT thread
+  std::atomic<uint64_t> tail {0};  // frames drained, owned by the writer
+
+  std::atomic<bool> recording {false};
+  std::atomic<bool> stopping {false};
+  std::atomic<uint64_t> dropped_frames {0};
+  std::atomic<uint64_t> written_bytes {0};
+  std::atomic<bool> write_failed {false};
+
+  int fd = -1;
+  bool direct = false;
+  // BLOCK_BYTES aligned so the writer can hand it to O_DIRECT as is
+  unsigned char* staging = nullptr;
+  size_t staging_size = 0;
+  size_t staging_fill = 0;
+  std::thread writer;
+};
+
+}  // namespace fir_window
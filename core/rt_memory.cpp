@@ -0,0 +1,170 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "rt_memory.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr size_t HUGE_PAGE_BYTES = size_t {2} << 20;
+
+// Bookkeeping at the start of every mapping. One cache line keeps the
+// payload as aligned as anything the kernels load.
+struct alignas(64) region_t
+{
+  size_t length;
+  bool locked;
+  bool huge;
+};
+
+std::atomic<size_t> live_regions {0};
+std::atomic<size_t> live_unlocked {0};
+std::atomic<size_t> live_huge {0};
+std::atomic<size_t> live_bytes {0};
+
+size_t round_up(size_t bytes, size_t unit)
+{
+  return (bytes + unit - 1) / unit * unit;
+}
+
+void* map(size_t length, int extra_flags)
+{
+  void* base = mmap(nullptr,
+                    length,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | extra_flags,
+                    -1,
+                    0);
+  return base == MAP_FAILED ? nullptr : base;
+}
+
+// Transparent huge pages only back huge page aligned ranges that are first
+// touched after madvise(), so the mapping is over-allocated, trimmed to an
+// aligned start and left unpopulated.
+void* map_transparent(size_t length)
+{
+  auto* raw = static_cast<unsigned char*>(map(length + HUGE_PAGE_BYTES, 0));
+  if (raw == nullptr) {
+    return nullptr;
+  }
+  const auto address = reinterpret_cast<uintptr_t>(raw);
+  const size_t head = round_up(address, HUGE_PAGE_BYTES) - address;
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  munmap(raw + head + length, HUGE_PAGE_BYTES - head);
+  madvise(raw + head, length, MADV_HUGEPAGE);
+  return raw + head;
+}
+
+// madvise() succeeds even with transparent huge pages disabled, so only
+// the kernel's accounting of the mapping holding base tells whether any of
+// it is actually backed by huge pages
+bool backed_by_huge_pages(const void* base)
+{
+  std::ifstream smaps("/proc/self/smaps");
+  const auto address = reinterpret_cast<uintptr_t>(base);
+  bool inside = false;
+  std::string line;
+  while (std::getline(smaps, line)) {
+    unsigned long low = 0;
+    unsigned long high = 0;
+    if (std::sscanf(line.c_str(), "%lx-%lx", &low, &high) == 2) {
+      inside = low <= address && address < high;
+      continue;
+    }
+    unsigned long kilobytes = 0;
+    if (inside
+        && std::sscanf(line.c_str(), "AnonHugePages: %lu", &kilobytes) == 1)
+    {
+      return kilobytes > 0;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+void* fir_window::rt_allocate(size_t bytes)
+{
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t wanted = sizeof(region_t) + bytes;
+
+  bool huge = false;
+  size_t length = 0;
+  void* base = nullptr;
+  if (wanted >= HUGE_PAGE_BYTES) {
+    length = round_up(wanted, HUGE_PAGE_BYTES);
+    base = map(length, MAP_HUGETLB | MAP_POPULATE);
+    huge = base != nullptr;
+    if (base == nullptr) {
+      base = map_transparent(length);
+    }
+  }
+  if (base == nullptr) {
+    length = round_up(wanted, page);
+    base = map(length, MAP_POPULATE);
+    if (base == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+
+  // MAP_POPULATE is only a hint; writing every page guarantees that it is
+  // backed before the real-time thread reads it
+  auto* bytes_base = static_cast<volatile unsigned char*>(base);
+  for (size_t offset = 0; offset < length; offset += page) {
+    bytes_base[offset] = 0;
+  }
+  const bool locked = mlock(base, length) == 0;
+  if (!huge && length >= HUGE_PAGE_BYTES) {
+    huge = backed_by_huge_pages(base);
+  }
+
+  auto* region = new (base) region_t {length, locked, huge};
+  live_regions++;
+  live_bytes += length;
+  if (!locked) {
+    live_unlocked++;
+  }
+  if (huge) {
+    live_huge++;
+  }
+  return region + 1;
+}
+
+void fir_window::rt_deallocate(void* pointer)
+{
+  if (pointer == nullptr) {
+    return;
+  }
+  region_t* region = static_cast<region_t*>(pointer) - 1;
+  const region_t info = *region;
+  live_regions--;
+  live_bytes -= info.length;
+  if (!info.locked) {
+    live_unlocked--;
+  }
+  if (info.huge) {
+    live_huge--;
+  }
+  if (info.locked) {
+    munlock(region, info.length);
+  }
+  munmap(region, info.length);
+}
+
+fir_window::RtMemoryStats fir_window::rt_memory_stats()
+{
+  RtMemoryStats stats;
+  stats.regions = live_regions.load();
+  stats.unlocked = live_unlocked.load();
+  stats.huge_pages = live_huge.load();
+  stats.bytes = live_bytes.load();
+  return stats;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace fir_window
+{
+
+// Memory for buffers the real-time thread touches. Every allocation is its
+// own anonymous mapping that is populated, written once per page and
+// mlock'ed before it is handed out, so the first period after a redesign
+// neither takes a page fault nor finds its buffers swapped out. Regions of
+// at least one huge page try explicit huge pages (MAP_HUGETLB) first and
+// fall back to an aligned mapping advised for transparent huge pages
+// (MADV_HUGEPAGE) to cut TLB misses on long filters. A region only counts
+// as huge if the kernel actually backed it that way.
+//
+// A region that cannot be locked, typically because RLIMIT_MEMLOCK is too
+// small, is still prefaulted and used; it is counted in rt_memory_stats()
+// so the caller can report it. Only a failed mapping throws std::bad_alloc.
+void* rt_allocate(size_t bytes);
+void rt_deallocate(void* pointer);
+
+// process-wide counts of live regions
+struct RtMemoryStats
+{
+  size_t regions = 0;
+  size_t unlocked = 0;  // could not be mlock'ed
+  size_t huge_pages = 0;  // backed by explicit or transparent huge pages
+  size_t bytes = 0;  // mapped, including page rounding
+};
+
+RtMemoryStats rt_memory_stats();
+
+template<typename T>
+struct RtAllocator
+{
+  using value_type = T;
+
+  RtAllocator() = default;
+  template<typename U>
+  RtAllocator(const RtAllocator<U>&) noexcept
+  {
+  }
+
+  T* allocate(size_t count)
+  {
+    return static_cast<T*>(rt_allocate(count * sizeof(T)));
+  }
+  void deallocate(T* pointer, size_t) noexcept { rt_deallocate(pointer); }
+
+  template<typename U>
+  bool operator==(const RtAllocator<U>&) const noexcept
+  {
+    return true;
+  }
+};
+
+// std::vector whose storage comes from rt_allocate()
+template<typename T>
+using rt_vector = std::vector<T, RtAllocator<T>>;
+
+}  // namespace fir_window
@@ -0,0 +1,671 @@
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <filesystem>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coefficient_cache.hpp"
+#include "cutoff_table.hpp"
+#include "design.hpp"
+#include "min_phase.hpp"
+#include "optimal_design.hpp"
+#include "tolerance_design.hpp"
+
+namespace
+{
+
+using namespace fir_window;
+
+struct reference_t
+{
+  window_t window;
+  filter_t filter;
+  std::array<double, 9> h;
+};
+
+// 9 taps, lambda1 = 0.2, lambda2 = 0.5, Kaiser alpha 1.5, Chebyshev 70 dB.
+// Generated by an independent implementation (Chebyshev window through a
+// full complex DFT of its sampled spectrum, Kaiser through the I0 power
+// series) printed to 17 significant digits.
+const reference_t REFERENCES[] = {
+    {RECT,
+     LOWPASS,
+     {0.046774464189431965, 0.10091023048542094, 0.1513653457281314,
+      0.1870978567577278, 0.20000000000000001, 0.1870978567577278,
+      0.1513653457281314, 0.10091023048542094, 0.046774464189431965}},
+    {RECT,
+     HIGHPASS,
+     {-0.046774464189431965, -0.10091023048542094, -0.1513653457281314,
+      -0.1870978567577278, 0.80000000000000004, -0.1870978567577278,
+      -0.1513653457281314, -0.10091023048542094, -0.046774464189431965}},
+    {RECT,
+     BANDPASS,
+     {-0.046774464189431986, -0.20701352588001784, -0.15136534572813137,
+      0.13121202942606289, 0.29999999999999999, 0.13121202942606289,
+      -0.15136534572813137, -0.20701352588001784, -0.046774464189431986}},
+    {RECT,
+     BANDSTOP,
+     {0.046774464189431986, 0.20701352588001784, 0.15136534572813137,
+      -0.13121202942606289, 0.69999999999999996, -0.13121202942606289,
+      0.15136534572813137, 0.20701352588001784, 0.046774464189431986}},
+    {TRI,
+     LOWPASS,
+     {0, 0.025227557621355236, 0.0756826728640657,
+      0.14032339256829585, 0.20000000000000001, 0.14032339256829585,
+      0.0756826728640657, 0.025227557621355236, 0}},
+    {TRI,
+     HIGHPASS,
+     {-0, -0.025227557621355236, -0.0756826728640657,
+      -0.14032339256829585, 0.80000000000000004, -0.14032339256829585,
+      -0.0756826728640657, -0.025227557621355236, -0}},
+    {TRI,
+     BANDPASS,
+     {-0, -0.05175338147000446, -0.075682672864065687,
+      0.098409022069547158, 0.29999999999999999, 0.098409022069547158,
+      -0.075682672864065687, -0.05175338147000446, -0}},
+    {TRI,
+     BANDSTOP,
+     {0, 0.05175338147000446, 0.075682672864065687,
+      -0.098409022069547158, 0.69999999999999996, -0.098409022069547158,
+      0.075682672864065687, 0.05175338147000446, 0}},
+    {HAMM,
+     LOWPASS,
+     {0.0037419571351545579, 0.021668542659151545, 0.081737286693190955,
+      0.161889997748248, 0.20000000000000001, 0.161889997748248,
+      0.081737286693190983, 0.021668542659151548, 0.0037419571351545579}},
+    {HAMM,
+     HIGHPASS,
+     {-0.0037419571351545579, -0.021668542659151545, -0.081737286693190955,
+      -0.161889997748248, 0.80000000000000004, -0.161889997748248,
+      -0.081737286693190983, -0.021668542659151548, -0.0037419571351545579}},
+    {HAMM,
+     BANDPASS,
+     {-0.0037419571351545596, -0.044452196719544805, -0.081737286693190941,
+      0.11353371714906618, 0.29999999999999999, 0.1135337171490662,
+      -0.081737286693190969, -0.044452196719544812, -0.0037419571351545596}},
+    {HAMM,
+     BANDSTOP,
+     {0.0037419571351545596, 0.044452196719544805, 0.081737286693190941,
+      -0.11353371714906618, 0.69999999999999996, -0.1135337171490662,
+      0.081737286693190969, 0.044452196719544812, 0.0037419571351545596}},
+    {HANN,
+     LOWPASS,
+     {0, 0.014777961109041157, 0.075682672864065687,
+      0.15969801000829323, 0.20000000000000001, 0.15969801000829323,
+      0.075682672864065714, 0.014777961109041168, 0}},
+    {HANN,
+     HIGHPASS,
+     {-0, -0.014777961109041157, -0.075682672864065687,
+      -0.15969801000829323, 0.80000000000000004, -0.15969801000829323,
+      -0.075682672864065714, -0.014777961109041168, -0}},
+    {HANN,
+     BANDPASS,
+     {-0, -0.030316428966460182, -0.075682672864065673,
+      0.11199647260324039, 0.29999999999999999, 0.1119964726032404,
+      -0.0756826728640657, -0.030316428966460203, -0}},
+    {HANN,
+     BANDSTOP,
+     {0, 0.030316428966460182, 0.075682672864065673,
+      -0.11199647260324039, 0.69999999999999996, -0.1119964726032404,
+      0.0756826728640657, 0.030316428966460203, 0}},
+    {CHEBY,
+     LOWPASS,
+     {0.0017807837938375946, 0.019588709051912505, 0.076201331300646852,
+      0.15841942240226684, 0.20000000000000001, 0.15841942240226684,
+      0.076201331300646852, 0.019588709051912505, 0.0017807837938375946}},
+    {CHEBY,
+     HIGHPASS,
+     {-0.0017807837938375946, -0.019588709051912505, -0.076201331300646852,
+      -0.15841942240226684, 0.80000000000000004, -0.15841942240226684,
+      -0.076201331300646852, -0.019588709051912505, -0.0017807837938375946}},
+    {CHEBY,
+     BANDPASS,
+     {-0.0017807837938375952, -0.040185496641592704, -0.076201331300646838,
+      0.11109979704803627, 0.29999999999999999, 0.11109979704803627,
+      -0.076201331300646838, -0.040185496641592704, -0.0017807837938375952}},
+    {CHEBY,
+     BANDSTOP,
+     {0.0017807837938375952, 0.040185496641592704, 0.076201331300646838,
+      -0.11109979704803627, 0.69999999999999996, -0.11109979704803627,
+      0.076201331300646838, 0.040185496641592704, 0.0017807837938375952}},
+    {KAISER,
+     LOWPASS,
+     {0.028404570045487066, 0.077313460265081291, 0.13498426088384455,
+      0.18191165477613686, 0.20000000000000001, 0.18191165477613686,
+      0.13498426088384455, 0.077313460265081291, 0.028404570045487066}},
+    {KAISER,
+     HIGHPASS,
+     {-0.028404570045487066, -0.077313460265081291, -0.13498426088384455,
+      -0.18191165477613686, 0.80000000000000004, -0.18191165477613686,
+      -0.13498426088384455, -0.077313460265081291, -0.028404570045487066}},
+    {KAISER,
+     BANDPASS,
+     {-0.02840457004548708, -0.15860564315896056, -0.13498426088384452,
+      0.12757493759181926, 0.29999999999999999, 0.12757493759181926,
+      -0.13498426088384452, -0.15860564315896056, -0.02840457004548708}},
+    {KAISER,
+     BANDSTOP,
+     {0.02840457004548708, 0.15860564315896056, 0.13498426088384452,
+      -0.12757493759181926, 0.69999999999999996, -0.12757493759181926,
+      0.13498426088384452, 0.15860564315896056, 0.02840457004548708}},
+};
+
+std::complex<double> response(const std::vector<double>& h, double omega)
+{
+  std::complex<double> sum = 0;
+  for (size_t n = 0; n < h.size(); n++) {
+    sum += h[n] * std::polar(1.0, -omega * static_cast<double>(n));
+  }
+  return sum;
+}
+
+TEST(Design, MatchesReferenceCoefficients)
+{
+  for (const auto& reference : REFERENCES) {
+    DesignSpec spec;
+    spec.window_shape = reference.window;
+    spec.filter_type = reference.filter;
+    spec.num_taps = 9;
+    spec.lambda1 = 0.2;
+    spec.lambda2 = 0.5;
+    spec.Kalpha = 1.5;
+    spec.Calpha = 70;
+    const std::vector<double> h = design_filter(spec);
+    ASSERT_EQ(h.size(), reference.h.size());
+    for (size_t n = 0; n < h.size(); n++) {
+      EXPECT_NEAR(h[n], reference.h[n], 1e-13)
+          << "window " << reference.window << " filter " << reference.filter
+          << " tap " << n;
+    }
+  }
+}
+
+TEST(Design, WindowsAreSymmetricWithUnitPeak)
+{
+  for (auto shape : {RECT, TRI, HAMM, HANN, CHEBY, KAISER}) {
+    const std::vector<double> window = make_window(shape, 101, 4.0, 60.0);
+    EXPECT_NEAR(window[50], 1.0, 1e-12) << "window " << shape;
+    for (size_t n = 0; n < window.size(); n++) {
+      EXPECT_NEAR(window[n], window[window.size() - 1 - n], 1e-12)
+          << "window " << shape << " tap " << n;
+      EXPECT_LE(window[n], 1.0 + 1e-12);
+    }
+  }
+}
+
+TEST(Design, PassbandAndStopbandGains)
+{
+  DesignSpec spec;
+  spec.window_shape = HAMM;
+  spec.num_taps = 201;
+  spec.lambda1 = 0.2;
+  spec.lambda2 = 0.5;
+
+  spec.filter_type = LOWPASS;
+  std::vector<double> h = design_filter(spec);
+  EXPECT_NEAR(std::abs(response(h, 0)), 1.0, 1e-3);
+  EXPECT_LT(std::abs(response(h, 0.5 * M_PI)), 1e-3);
+
+  spec.filter_type = HIGHPASS;
+  h = design_filter(spec);
+  EXPECT_LT(std::abs(response(h, 0)), 1e-3);
+  EXPECT_NEAR(std::abs(response(h, M_PI)), 1.0, 1e-3);
+
+  spec.filter_type = BANDPASS;
+  h = design_filter(spec);
+  EXPECT_LT(std::abs(response(h, 0)), 1e-3);
+  EXPECT_NEAR(std::abs(response(h, 0.35 * M_PI)), 1.0, 1e-3);
+  EXPECT_LT(std::abs(response(h, M_PI)), 1e-3);
+
+  spec.filter_type = BANDSTOP;
+  h = design_filter(spec);
+  EXPECT_NEAR(std::abs(response(h, 0)), 1.0, 1e-3);
+  EXPECT_LT(std::abs(response(h, 0.35 * M_PI)), 1e-3);
+  EXPECT_NEAR(std::abs(response(h, M_PI)), 1.0, 1e-3);
+}
+
+// largest weighted deviation of |H| from the target over the bands and
+// the integrated weighted squared error, both on a dense grid
+struct band_error_t
+{
+  double peak = 0;
+  double squared = 0;
+};
+
+band_error_t band_error(const std::vector<double>& h,
+                        const std::vector<band_t>& bands)
+{
+  band_error_t result;
+  for (const auto& band : bands) {
+    const int points = 2000;
+    for (int i = 0; i <= points; i++) {
+      const double f = band.low + (band.high - band.low) * i / points;
+      const double deviation =
+          band.weight * (std::abs(response(h, M_PI * f)) - band.desired);
+      result.peak = std::max(result.peak, std::fabs(deviation));
+      result.squared += deviation * deviation * (band.high - band.low) / points;
+    }
+  }
+  return result;
+}
+
+TEST(Design, EquirippleLevelsTheWeightedError)
+{
+  for (auto type : {LOWPASS, HIGHPASS, BANDPASS, BANDSTOP}) {
+    DesignSpec spec;
+    spec.method = EQUIRIPPLE;
+    spec.filter_type = type;
+    spec.num_taps = 61;
+    spec.lambda1 = 0.3;
+    spec.lambda2 = 0.6;
+    spec.transition = 0.08;
+    for (double stop_weight : {1.0, 10.0}) {
+      spec.stopband_weight = stop_weight;
+      const std::vector<double> h = design_filter(spec);
+      ASSERT_EQ(h.size(), spec.num_taps);
+      for (size_t n = 0; n < h.size(); n++) {
+        EXPECT_EQ(h[n], h[h.size() - 1 - n]);
+      }
+      // every band peaks at the same weighted error
+      double lowest = HUGE_VAL;
+      double highest = 0;
+      for (const auto& band : design_bands(spec)) {
+        const double peak = band_error(h, {band}).peak;
+        lowest = std::min(lowest, peak);
+        highest = std::max(highest, peak);
+      }
+      EXPECT_LT(highest, 1.01 * lowest)
+          << "type " << type << " stopband weight " << stop_weight;
+    }
+  }
+}
+
+TEST(Design, OptimalDesignsNeedAPassband)
+{
+  DesignSpec spec;
+  spec.num_taps = 31;
+  spec.filter_type = BANDPASS;
+  spec.lambda1 = 0.40;
+  spec.lambda2 = 0.45;
+  spec.transition = 0.1;
+  ASSERT_EQ(design_bands(spec).size(), 2U);
+  for (auto method : {EQUIRIPPLE, LEAST_SQUARES}) {
+    spec.method = method;
+    EXPECT_THROW(design_filter(spec), std::invalid_argument);
+  }
+  EXPECT_THROW(design_equiripple(31, {}), std::invalid_argument);
+
+  // a single tap is still designed, as the best constant gain
+  spec.method = EQUIRIPPLE;
+  spec.filter_type = LOWPASS;
+  spec.lambda1 = 0.5;
+  spec.num_taps = 1;
+  const std::vector<double> h = design_filter(spec);
+  ASSERT_EQ(h.size(), 1U);
+  EXPECT_TRUE(std::isfinite(h[0]));
+}
+
+TEST(Design, OptimalDesignsBeatTheWindowMethod)
+{
+  DesignSpec spec;
+  spec.filter_type = LOWPASS;
+  spec.num_taps = 51;
+  spec.lambda1 = 0.25;
+  spec.transition = 0.1;
+  spec.window_shape = KAISER;
+  spec.Kalpha = 4.5;  // about the same transition width at 51 taps
+  const std::vector<band_t> bands = design_bands(spec);
+
+  const band_error_t window = band_error(design_filter(spec), bands);
+  spec.method = EQUIRIPPLE;
+  const band_error_t equiripple = band_error(design_filter(spec), bands);
+  spec.method = LEAST_SQUARES;
+  const band_error_t least_squares = band_error(design_filter(spec), bands);
+
+  // each method wins on the criterion it optimizes
+  EXPECT_LT(equiripple.peak, window.peak);
+  EXPECT_LT(equiripple.peak, least_squares.peak);
+  EXPECT_LT(least_squares.squared, window.squared);
+  EXPECT_LT(least_squares.squared, equiripple.squared);
+}
+
+TEST(Design, ToleranceFitFindsTheShortestDesign)
+{
+  Tolerance tolerance;
+  tolerance.passband_ripple_db = 0.1;
+  tolerance.stopband_attenuation_db = 60;
+
+  size_t window_taps = 0;
+  size_t equiripple_taps = 0;
+  for (auto method : {WINDOW_METHOD, EQUIRIPPLE, LEAST_SQUARES}) {
+    for (auto type : {LOWPASS, BANDPASS}) {
+      DesignSpec base;
+      base.method = method;
+      base.window_shape = KAISER;
+      base.filter_type = type;
+      base.lambda1 = 0.2;
+      base.lambda2 = 0.5;
+      base.transition = 0.05;
+      const ToleranceFit fit = fit_to_tolerance(base, tolerance, 2001);
+      ASSERT_TRUE(fit.met) << "method " << method << " type " << type;
+      EXPECT_EQ(fit.spec.num_taps % 2, 1U);
+
+      // the reported design meets the tolerance, two taps fewer does not
+      DesignSpec spec = fit.spec;
+      Tolerance achieved = measure_tolerance(design_filter(spec), spec);
+      EXPECT_LE(achieved.passband_ripple_db, tolerance.passband_ripple_db);
+      EXPECT_GE(achieved.stopband_attenuation_db,
+                tolerance.stopband_attenuation_db);
+      spec.num_taps -= 2;
+      achieved = measure_tolerance(design_filter(spec), spec);
+      EXPECT_TRUE(
+          achieved.passband_ripple_db > tolerance.passband_ripple_db
+          || achieved.stopband_attenuation_db
+              < tolerance.stopband_attenuation_db)
+          << "method " << method << " type " << type;
+
+      if (type == LOWPASS && method == WINDOW_METHOD) {
+        window_taps = fit.spec.num_taps;
+      } else if (type == LOWPASS && method == EQUIRIPPLE) {
+        equiripple_taps = fit.spec.num_taps;
+      }
+    }
+  }
+  EXPECT_LT(equiripple_taps, window_taps * 0.85);
+
+  // Herrmann's D-infinity by hand: d1 = -2, d2 = -3, 0.1 cycles/sample
+  // gives 25.26 taps
+  EXPECT_EQ(herrmann_taps(0.01, 0.001, 0.2), 27U);
+  EXPECT_EQ(herrmann_taps(0.001, 0.01, 0.2), 27U);
+
+  // a window whose sidelobes can never reach the attenuation gives up at
+  // the limit
+  DesignSpec rectangular;
+  rectangular.window_shape = RECT;
+  const ToleranceFit fit = fit_to_tolerance(rectangular, tolerance, 301);
+  EXPECT_FALSE(fit.met);
+  EXPECT_EQ(fit.spec.num_taps, 301U);
+}
+
+TEST(Design, MinimumPhaseKeepsMagnitudeAndCutsDelay)
+{
+  DesignSpec spec;
+  spec.window_shape = KAISER;
+  spec.Kalpha = 6;
+  spec.num_taps = 301;
+  spec.lambda1 = 0.1;
+  const std::vector<double> linear = design_filter(spec);
+  spec.phase_response = MINIMUM_PHASE;
+  const std::vector<double> minimum = design_filter(spec);
+
+  ASSERT_EQ(minimum.size(), linear.size());
+  for (double omega = 0; omega < M_PI; omega += M_PI / 64) {
+    EXPECT_NEAR(std::abs(response(minimum, omega)),
+                std::abs(response(linear, omega)),
+                1e-4);
+  }
+  EXPECT_NEAR(group_delay(linear.data(), linear.size(), 0), 150.0, 1e-9);
+  EXPECT_LT(group_delay(minimum.data(), minimum.size(), 0), 30.0);
+}
+
+TEST(Design, QuadratureIsInBandHilbertPartner)
+{
+  DesignSpec spec;
+  spec.window_shape = KAISER;
+  spec.Kalpha = 6;
+  spec.filter_type = BANDPASS;
+  spec.num_taps = 301;
+  spec.lambda1 = 0.1;
+  spec.lambda2 = 0.3;
+  const std::vector<double> in_phase = design_filter(spec);
+  const std::vector<double> quadrature = design_quadrature(spec);
+
+  for (size_t n = 0; n < quadrature.size(); n++) {
+    EXPECT_NEAR(quadrature[n], -quadrature[quadrature.size() - 1 - n], 1e-15);
+  }
+  // inside the band Q(w) = -j I(w): same gain, 90 degrees behind
+  for (double omega = 0.14 * M_PI; omega < 0.26 * M_PI; omega += 0.01 * M_PI) {
+    const std::complex<double> i = response(in_phase, omega);
+    const std::complex<double> q = response(quadrature, omega);
+    EXPECT_NEAR(std::abs(q), std::abs(i), 1e-3);
+    EXPECT_NEAR(std::abs(q - std::complex<double>(0, -1) * i), 0.0, 1e-3);
+  }
+}
+
+TEST(Design, CutoffTableMatchesFullRedesign)
+{
+  DesignSpec spec;
+  spec.window_shape = KAISER;
+  spec.Kalpha = 5;
+  spec.num_taps = 401;
+  CutoffTable table;
+  table.build(spec, 0.05, 0.4);
+  std::vector<double> h(table.taps());
+  for (auto type : {LOWPASS, HIGHPASS, BANDPASS, BANDSTOP}) {
+    for (double lambda = 0.05; lambda + 0.1 <= 0.4; lambda += 0.0123) {
+      spec.filter_type = type;
+      spec.lambda1 = lambda;
+      spec.lambda2 = lambda + 0.1;
+      const std::vector<double> reference = design_filter(spec);
+      table.design(type, spec.lambda1, spec.lambda2, h.data());
+      for (size_t n = 0; n < h.size(); n++) {
+        ASSERT_NEAR(h[n], reference[n], 2e-5)
+            << "filter " << type << " cutoff " << lambda << " tap " << n;
+      }
+    }
+  }
+  EXPECT_LE(table.interpolationError(), 1e-5);
+
+  // long filters still get the bound as long as the table fits
+  spec.num_taps = 1001;
+  table.build(spec, 0.05, 0.4);
+  EXPECT_LE(table.interpolationError(), 1e-5);
+  spec.filter_type = LOWPASS;
+  spec.lambda1 = 0.2037;
+  const std::vector<double> reference = design_filter(spec);
+  h.resize(table.taps());
+  table.design(LOWPASS, spec.lambda1, spec.lambda1, h.data());
+  for (size_t n = 0; n < h.size(); n++) {
+    ASSERT_NEAR(h[n], reference[n], 1e-5) << "tap " << n;
+  }
+
+  // and report a coarser one when they do not
+  spec.num_taps = 20001;
+  table.build(spec, 0.0, 1.0);
+  EXPECT_GT(table.interpolationError(), 1e-5);
+}
+
+TEST(Design, CoefficientCacheRoundTripsAndRejectsDamage)
+{
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "fir-window-cache-test";
+  std::filesystem::remove_all(directory);
+
+  DesignSpec spec;
+  spec.window_shape = CHEBY;
+  spec.filter_type = BANDPASS;
+  spec.num_taps = 101;
+  const std::vector<double> designed = design_filter(spec);
+
+  CoefficientCache cache(directory);
+  EXPECT_EQ(cache.design(spec), designed);
+  EXPECT_EQ(cache.misses(), 1U);
+  const std::filesystem::path entry =
+      cache.entry(spec, CoefficientCache::FILTER);
+  EXPECT_TRUE(std::filesystem::exists(entry));
+
+  // a second instance reads the same bits back without designing
+  CoefficientCache reader(directory);
+  EXPECT_EQ(reader.design(spec), designed);
+  EXPECT_EQ(reader.hits(), 1U);
+  EXPECT_EQ(reader.design(spec, CoefficientCache::QUADRATURE),
+            design_quadrature(spec));
+  EXPECT_EQ(reader.misses(), 1U);
+
+  // any other spec is a different entry
+  DesignSpec other = spec;
+  other.Calpha = 60;
+  EXPECT_NE(cache.entry(other, CoefficientCache::FILTER), entry);
+  other = spec;
+  other.method = EQUIRIPPLE;
+  EXPECT_NE(cache.entry(other, CoefficientCache::FILTER), entry);
+
+  // a flipped payload byte fails the checksum and is redesigned
+  std::FILE* file = std::fopen(entry.c_str(), "r+b");
+  ASSERT_NE(file, nullptr);
+  std::fseek(file, -3, SEEK_END);
+  const int byte = std::fgetc(file);
+  std::fseek(file, -3, SEEK_END);
+  std::fputc(byte ^ 0xff, file);
+  std::fclose(file);
+  std::vector<double> h;
+  EXPECT_FALSE(reader.load(spec, CoefficientCache::FILTER, h));
+  EXPECT_EQ(reader.design(spec), designed);
+  EXPECT_TRUE(reader.load(spec, CoefficientCache::FILTER, h));
+
+  // a truncated file is a miss, not a crash
+  std::filesystem::resize_file(entry, 40);
+  EXPECT_FALSE(reader.load(spec, CoefficientCache::FILTER, h));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Design, CoefficientCacheKeepsToleranceFits)
+{
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "fir-window-cache-fit-test";
+  std::filesystem::remove_all(directory);
+
+  DesignSpec base;
+  base.method = EQUIRIPPLE;
+  base.filter_type = LOWPASS;
+  base.lambda1 = 0.3;
+  base.transition = 0.05;
+  Tolerance tolerance;
+  tolerance.stopband_attenuation_db = 70;
+  const ToleranceFit searched = fit_to_tolerance(base, tolerance, 2001);
+
+  CoefficientCache cache(directory);
+  ToleranceFit fit = cache.fit(base, tolerance, 2001);
+  EXPECT_EQ(cache.misses(), 1U);
+  // a second instance skips the search, whatever tap count it starts from
+  CoefficientCache reader(directory);
+  base.num_taps = 7;
+  fit = reader.fit(base, tolerance, 2001);
+  EXPECT_EQ(reader.hits(), 1U);
+  EXPECT_EQ(fit.spec.num_taps, searched.spec.num_taps);
+  EXPECT_EQ(fit.spec.stopband_weight, searched.spec.stopband_weight);
+  EXPECT_EQ(fit.spec.Kalpha, searched.spec.Kalpha);
+  EXPECT_EQ(fit.spec.method, EQUIRIPPLE);
+  EXPECT_EQ(fit.met, searched.met);
+  EXPECT_EQ(fit.achieved.stopband_attenuation_db,
+            searched.achieved.stopband_attenuation_db);
+
+  // another tolerance or tap limit is another search
+  const std::filesystem::path entry = cache.fitEntry(base, tolerance, 2001);
+  EXPECT_NE(cache.fitEntry(base, tolerance, 101), entry);
+  Tolerance other = tolerance;
+  other.passband_ripple_db = 0.5;
+  EXPECT_NE(cache.fitEntry(base, other, 2001), entry);
+  fit = reader.fit(base, tolerance, 101);
+  EXPECT_EQ(reader.misses(), 1U);
+  EXPECT_FALSE(fit.met);
+
+  // a damaged outcome is searched again
+  std::filesystem::resize_file(entry, 40);
+  ASSERT_FALSE(reader.loadFit(base, tolerance, 2001, fit));
+  EXPECT_EQ(reader.fit(base, tolerance, 2001).spec.num_taps,
+            searched.spec.num_taps);
+  EXPECT_TRUE(reader.loadFit(base, tolerance, 2001, fit));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Design, CoefficientCacheEvictsLeastRecentlyUsed)
+{
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "fir-window-cache-trim-test";
+  std::filesystem::remove_all(directory);
+
+  // room for two entries of 101 taps, not three
+  CoefficientCache cache(directory, 2000);
+  std::vector<DesignSpec> specs(3);
+  for (size_t i = 0; i < specs.size(); i++) {
+    specs[i].num_taps = 101;
+    specs[i].lambda1 = 0.1 * static_cast<double>(i + 1);
+  }
+  cache.design(specs[0]);
+  cache.design(specs[1]);
+  // file times have a coarse resolution on some filesystems
+  const auto age = [&](const DesignSpec& spec, int seconds)
+  {
+    std::filesystem::last_write_time(
+        cache.entry(spec, CoefficientCache::FILTER),
+        std::filesystem::file_time_type::clock::now()
+            - std::chrono::seconds(seconds));
+  };
+  age(specs[0], 20);
+  age(specs[1], 10);
+  // a hit makes the first entry the most recently used
+  cache.design(specs[0]);
+  EXPECT_EQ(cache.hits(), 1U);
+  cache.design(specs[2]);
+
+  EXPECT_TRUE(std::filesystem::exists(
+      cache.entry(specs[0], CoefficientCache::FILTER)));
+  EXPECT_FALSE(std::filesystem::exists(
+      cache.entry(specs[1], CoefficientCache::FILTER)));
+  EXPECT_TRUE(std::filesystem::exists(
+      cache.entry(specs[2], CoefficientCache::FILTER)));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Design, CoefficientCacheDesignsConcurrently)
+{
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "fir-window-cache-thread-test";
+  std::filesystem::remove_all(directory);
+
+  // as for the bands of a filter bank, twice each so hits race stores
+  CoefficientCache cache(directory);
+  std::vector<DesignSpec> specs(8);
+  for (size_t i = 0; i < specs.size(); i++) {
+    specs[i].method = EQUIRIPPLE;
+    specs[i].filter_type = BANDPASS;
+    specs[i].num_taps = 101;
+    specs[i].lambda1 = 0.1 * static_cast<double>(i % 4) + 0.05;
+    specs[i].lambda2 = specs[i].lambda1 + 0.1;
+  }
+  std::vector<std::vector<double>> designed(specs.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < specs.size(); i++) {
+    threads.emplace_back([&, i] { designed[i] = cache.design(specs[i]); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < specs.size(); i++) {
+    EXPECT_EQ(designed[i], design_filter(specs[i])) << "spec " << i;
+  }
+  EXPECT_EQ(cache.hits() + cache.misses(), specs.size());
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Design, TapCountIsOdd)
+{
+  EXPECT_EQ(odd_taps(9), 9U);
+  EXPECT_EQ(odd_taps(10), 11U);
+  EXPECT_EQ(odd_taps(0), 1U);
+  EXPECT_EQ(odd_taps(-4), 1U);
+}
+
+}  // namespace
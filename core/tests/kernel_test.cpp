@@ -0,0 +1,683 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "coefficient_registry.hpp"
+#include "design.hpp"
+#include "filter_bank.hpp"
+#include "fir_filter.hpp"
+#include "moving_average.hpp"
+#include "parallel_bank.hpp"
+#include "partitioned_convolver.hpp"
+#include "perf_counters.hpp"
+#include "recorder.hpp"
+#include "rt_memory.hpp"
+
+#include <unistd.h>
+
+namespace
+{
+
+using namespace fir_window;
+
+constexpr double EPSILON = std::numeric_limits<double>::epsilon();
+
+std::vector<double> random_signal(size_t length, unsigned seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  std::vector<double> signal(length);
+  for (auto& sample : signal) {
+    sample = distribution(generator);
+  }
+  return signal;
+}
+
+// Naive reference y[n] = sum_k h[k] x[n - k] with zero initial history.
+// magnitude[n] = sum_k |h[k] x[n - k]| scales the rounding error bound.
+struct reference_t
+{
+  std::vector<double> output;
+  std::vector<double> magnitude;
+};
+
+reference_t convolve(const std::vector<double>& h, const std::vector<double>& x)
+{
+  reference_t result {std::vector<double>(x.size()),
+                      std::vector<double>(x.size())};
+  for (size_t n = 0; n < x.size(); n++) {
+    for (size_t k = 0; k < h.size() && k <= n; k++) {
+      result.output[n] += h[k] * x[n - k];
+      result.magnitude[n] += std::fabs(h[k] * x[n - k]);
+    }
+  }
+  return result;
+}
+
+// Any summation order of an N term dot product stays within
+// N * eps * sum |terms| of the exact value, so two orders differ by at
+// most twice that.
+double dot_product_bound(size_t terms, double magnitude)
+{
+  return 2.0 * static_cast<double>(terms) * EPSILON * magnitude;
+}
+
+TEST(Kernel, DirectFilterReturnsImpulseResponse)
+{
+  // an asymmetric response catches a kernel that reverses or offsets taps
+  const std::vector<double> h = {1, 2, 3, 4, 5, 6, 7};
+  FirFilter filter;
+  filter.setCoefficients(h.data(), h.size());
+  EXPECT_EQ(filter.process(1.0), 1.0);
+  for (size_t n = 1; n < h.size(); n++) {
+    EXPECT_EQ(filter.process(0.0), h[n]);
+  }
+  EXPECT_EQ(filter.process(0.0), 0.0);
+}
+
+TEST(Kernel, DirectFilterMatchesReference)
+{
+  for (size_t taps : {1, 9, 101, 1001}) {
+    const std::vector<double> h = random_signal(taps, 1);
+    const std::vector<double> x = random_signal(4000, 2);
+    const reference_t reference = convolve(h, x);
+    FirFilter filter;
+    filter.setCoefficients(h.data(), h.size());
+    for (size_t n = 0; n < x.size(); n++) {
+      ASSERT_NEAR(filter.process(x[n]),
+                  reference.output[n],
+                  dot_product_bound(taps, reference.magnitude[n]))
+          << "taps " << taps << " sample " << n;
+    }
+  }
+}
+
+TEST(Kernel, DirectFilterKeepsHistoryAcrossRedesign)
+{
+  const std::vector<double> h = random_signal(31, 3);
+  const std::vector<double> x = random_signal(200, 4);
+  const reference_t reference = convolve(h, x);
+  FirFilter filter;
+  filter.setCoefficients(h.data(), h.size());
+  for (size_t n = 0; n < x.size(); n++) {
+    if (n == 100) {
+      filter.setCoefficients(h.data(), h.size());
+    }
+    ASSERT_NEAR(filter.process(x[n]),
+                reference.output[n],
+                dot_product_bound(h.size(), reference.magnitude[n]));
+  }
+}
+
+TEST(Kernel, DirectFilterCopiesHistoryOfEqualLength)
+{
+  const std::vector<double> h = random_signal(31, 3);
+  const std::vector<double> x = random_signal(200, 4);
+  const reference_t reference = convolve(h, x);
+  FirFilter first;
+  first.setCoefficients(h.data(), h.size());
+  for (size_t n = 0; n < 100; n++) {
+    first.push(x[n]);
+  }
+  // a filter of another length keeps its own history
+  FirFilter other;
+  other.setCoefficients(h.data(), h.size() - 2);
+  other.copyHistory(first);
+  EXPECT_EQ(other.process(0.0), 0.0);
+
+  FirFilter second;
+  second.setCoefficients(h.data(), h.size());
+  second.copyHistory(first);
+  for (size_t n = 100; n < x.size(); n++) {
+    ASSERT_NEAR(second.process(x[n]),
+                reference.output[n],
+                dot_product_bound(h.size(), reference.magnitude[n]));
+  }
+}
+
+TEST(Kernel, BlockProcessingMatchesReference)
+{
+  // block sizes straddle both the output block and the staging chunk
+  const std::vector<size_t> blocks = {1, 3, 4, 7, 64, 255, 256, 257, 1000};
+  for (size_t taps : {1, 9, 101, 1001}) {
+    const std::vector<double> h = random_signal(taps, 1);
+    const std::vector<double> x = random_signal(6000, 2);
+    const reference_t reference = convolve(h, x);
+    FirFilter filter;
+    filter.setCoefficients(h.data(), h.size());
+    std::vector<double> y(x.size());
+    size_t n = 0;
+    for (size_t call = 0; n < x.size(); call++) {
+      const size_t count = std::min(blocks[call % blocks.size()], x.size() - n);
+      if (call % 5 == 4) {
+        // single samples interleave with blocks on the same history
+        y[n] = filter.process(x[n]);
+        n++;
+        continue;
+      }
+      filter.process(std::span<const double>(x.data() + n, count),
+                     std::span<double>(y.data() + n, count));
+      n += count;
+    }
+    for (n = 0; n < x.size(); n++) {
+      ASSERT_NEAR(y[n],
+                  reference.output[n],
+                  dot_product_bound(taps, reference.magnitude[n]))
+          << "taps " << taps << " sample " << n;
+    }
+  }
+}
+
+TEST(Kernel, FilterBankMatchesReference)
+{
+  for (size_t bands : {1, 3, 4, 5, 8}) {
+    const size_t taps = 63;
+    std::vector<std::vector<double>> h;
+    FilterBank bank;
+    bank.resize(bands, taps);
+    for (size_t band = 0; band < bands; band++) {
+      h.push_back(random_signal(taps, 10 + static_cast<unsigned>(band)));
+      bank.setBand(band, h.back().data());
+    }
+    const std::vector<double> x = random_signal(1000, 5);
+    std::vector<reference_t> reference;
+    for (const auto& band : h) {
+      reference.push_back(convolve(band, x));
+    }
+    std::vector<double> out(bands);
+    for (size_t n = 0; n < x.size(); n++) {
+      bank.push(x[n]);
+      bank.compute(out.data());
+      for (size_t band = 0; band < bands; band++) {
+        ASSERT_NEAR(out[band],
+                    reference[band].output[n],
+                    dot_product_bound(taps, reference[band].magnitude[n]))
+            << "bands " << bands << " band " << band << " sample " << n;
+      }
+    }
+  }
+}
+
+TEST(Kernel, ParallelBankMatchesReference)
+{
+  const size_t bands = 6;
+  const size_t taps = 1001;
+  std::vector<std::vector<double>> h;
+  FilterBank bank;
+  bank.resize(bands, taps);
+  for (size_t band = 0; band < bands; band++) {
+    h.push_back(random_signal(taps, 20 + static_cast<unsigned>(band)));
+    bank.setBand(band, h.back().data());
+  }
+  const std::vector<double> x = random_signal(200, 9);
+  std::vector<reference_t> reference;
+  for (const auto& band : h) {
+    reference.push_back(convolve(band, x));
+  }
+
+  // a period-length deadline and one that cannot be met: the output must
+  // not depend on whether the helpers or the inline fallback did the work
+  for (int64_t deadline : {int64_t {1000000}, int64_t {0}}) {
+    bank.clear();
+    ParallelBank parallel;
+    parallel.start(&bank, {-1, -1, -1}, deadline);
+    EXPECT_EQ(parallel.helpers(), 3U);
+    std::vector<double> out(bands);
+    for (size_t n = 0; n < x.size(); n++) {
+      bank.push(x[n]);
+      parallel.compute(out.data());
+      for (size_t band = 0; band < bands; band++) {
+        ASSERT_NEAR(out[band],
+                    reference[band].output[n],
+                    dot_product_bound(taps, reference[band].magnitude[n]))
+            << "deadline " << deadline << " band " << band << " sample "
+            << n;
+      }
+    }
+    parallel.stop();
+  }
+}
+
+TEST(Kernel, ParallelBankStartsWhileComputing)
+{
+  const size_t bands = 4;
+  const size_t taps = 1001;
+  std::vector<std::vector<double>> h;
+  FilterBank bank;
+  bank.resize(bands, taps);
+  for (size_t band = 0; band < bands; band++) {
+    h.push_back(random_signal(taps, 30 + static_cast<unsigned>(band)));
+    bank.setBand(band, h.back().data());
+  }
+  const std::vector<double> x = random_signal(2000, 12);
+  std::vector<reference_t> reference;
+  for (const auto& band : h) {
+    reference.push_back(convolve(band, x));
+  }
+
+  // the helpers join in part way through, as after a retune
+  ParallelBank parallel;
+  parallel.attach(&bank, 1000000);
+  EXPECT_EQ(parallel.helpers(), 0U);
+  std::thread starter([&parallel] { parallel.start({-1, -1}); });
+  std::vector<double> out(bands);
+  for (size_t n = 0; n < x.size(); n++) {
+    bank.push(x[n]);
+    parallel.compute(out.data());
+    for (size_t band = 0; band < bands; band++) {
+      ASSERT_NEAR(out[band],
+                  reference[band].output[n],
+                  dot_product_bound(taps, reference[band].magnitude[n]))
+          << "band " << band << " sample " << n;
+    }
+  }
+  starter.join();
+  EXPECT_EQ(parallel.helpers(), 2U);
+
+  // a pool told to stop first never starts
+  ParallelBank stopped;
+  stopped.attach(&bank, 1000000);
+  stopped.requestStop();
+  stopped.start({-1, -1});
+  EXPECT_EQ(stopped.helpers(), 0U);
+}
+
+TEST(Kernel, MovingAverageMatchesReference)
+{
+  const std::vector<double> x = random_signal(3000, 11);
+  for (const auto& [length, stages] :
+       {std::pair<size_t, size_t> {1, 1}, {7, 1}, {64, 2}, {50, 4}})
+  {
+    const std::vector<double> h = moving_average_response(length, stages);
+    ASSERT_EQ(h.size(), (length - 1) * stages + 1);
+    const reference_t reference = convolve(h, x);
+    MovingAverage filter;
+    filter.configure(length, stages);
+    std::vector<double> block(x.size());
+    for (size_t n = 0; n < x.size(); n++) {
+      ASSERT_NEAR(filter.process(x[n]),
+                  reference.output[n],
+                  dot_product_bound(h.size(), reference.magnitude[n])
+                      + 4 * static_cast<double>(stages) * EPSILON)
+          << "length " << length << " stages " << stages << " sample " << n;
+    }
+    filter.clear();
+    filter.process(x, block);
+    for (size_t n = 0; n < x.size(); n++) {
+      ASSERT_NEAR(block[n],
+                  reference.output[n],
+                  dot_product_bound(h.size(), reference.magnitude[n])
+                      + 4 * static_cast<double>(stages) * EPSILON);
+    }
+  }
+}
+
+TEST(Kernel, MovingAverageDoesNotDrift)
+{
+  // a large offset makes every add of a plain running sum round
+  const size_t length = 1000;
+  std::vector<double> x = random_signal(2000000, 12);
+  for (auto& sample : x) {
+    sample += 1000;
+  }
+  MovingAverage filter;
+  filter.configure(length, 1);
+  double y = 0;
+  for (double sample : x) {
+    y = filter.process(sample);
+  }
+  long double exact = 0;
+  for (size_t n = x.size() - length; n < x.size(); n++) {
+    exact += x[n];
+  }
+  exact /= length;
+  EXPECT_NEAR(y, static_cast<double>(exact), 4 * 1000 * EPSILON);
+}
+
+TEST(Kernel, MovingAverageCopiesHistory)
+{
+  const std::vector<double> x = random_signal(500, 13);
+  MovingAverage running;
+  running.configure(40, 3);
+  for (size_t n = 0; n < 300; n++) {
+    running.process(x[n]);
+  }
+  MovingAverage next;
+  next.configure(40, 3);
+  next.copyHistory(running);
+  for (size_t n = 300; n < x.size(); n++) {
+    ASSERT_EQ(next.process(x[n]), running.process(x[n])) << "sample " << n;
+  }
+  EXPECT_DOUBLE_EQ(next.groupDelay(), 39 * 3 / 2.0);
+
+  // another length starts from silence
+  MovingAverage shorter;
+  shorter.configure(20, 3);
+  shorter.copyHistory(running);
+  EXPECT_EQ(shorter.process(0), 0);
+}
+
+TEST(Kernel, PartitionedConvolverMatchesReference)
+{
+  for (size_t taps : {100, 1001, 5000}) {
+    const std::vector<double> h = random_signal(taps, 6);
+    const std::vector<double> x = random_signal(12000, 7);
+    const reference_t reference = convolve(h, x);
+    PartitionedConvolver convolver;
+    convolver.configure(h.data(), h.size(), 256);
+    const size_t block = convolver.headTaps() / 2;
+
+    // FFT rounding grows with log2 of the transform length and with the
+    // energy of the whole block, not just of the terms of one output
+    double total = 0;
+    for (double value : h) {
+      total += std::fabs(value);
+    }
+    const double bound = 64.0 * EPSILON * std::log2(4.0 * block) * total;
+    for (size_t n = 0; n < x.size(); n++) {
+      ASSERT_NEAR(convolver.process(x[n]), reference.output[n], bound)
+          << "taps " << taps << " sample " << n;
+      if ((n + 1) % block == 0) {
+        // the helper thread has a full block period to answer
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    EXPECT_EQ(convolver.missedDeadlines(), 0U);
+  }
+}
+
+TEST(Kernel, PartitionedConvolverCopiesHistory)
+{
+  const size_t taps = 5000;
+  const std::vector<double> h = random_signal(taps, 6);
+  const std::vector<double> x = random_signal(12000, 7);
+  const reference_t reference = convolve(h, x);
+  double total = 0;
+  for (double value : h) {
+    total += std::fabs(value);
+  }
+
+  // switch in the middle of a block, as a retune usually does
+  PartitionedConvolver first;
+  first.configure(h.data(), h.size(), 256);
+  const size_t block = first.headTaps() / 2;
+  const double bound = 64.0 * EPSILON * std::log2(4.0 * block) * total;
+  const size_t switch_at = 20 * block + block / 3;
+  for (size_t n = 0; n < switch_at; n++) {
+    first.process(x[n]);
+    if ((n + 1) % block == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  // the same taps again: with the history the output goes on unchanged
+  PartitionedConvolver second;
+  second.configure(h.data(), h.size(), 256);
+  second.copyHistory(first);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  for (size_t n = switch_at; n < x.size(); n++) {
+    ASSERT_NEAR(second.process(x[n]), reference.output[n], bound)
+        << "sample " << n;
+    if ((n + 1) % block == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  EXPECT_EQ(second.missedDeadlines(), 0U);
+
+  // a different length starts from silence
+  PartitionedConvolver shorter;
+  shorter.configure(h.data(), taps - 1000, 256);
+  shorter.copyHistory(first);
+  EXPECT_EQ(shorter.process(0.0), 0.0);
+}
+
+TEST(Kernel, DesignedFiltersMatchReference)
+{
+  // every window/filter combination through the production kernel
+  for (auto shape : {RECT, TRI, HAMM, HANN, CHEBY, KAISER}) {
+    for (auto type : {LOWPASS, HIGHPASS, BANDPASS, BANDSTOP}) {
+      DesignSpec spec;
+      spec.window_shape = shape;
+      spec.filter_type = type;
+      spec.num_taps = 51;
+      spec.lambda1 = 0.15;
+      spec.lambda2 = 0.45;
+      const std::vector<double> h = design_filter(spec);
+      const std::vector<double> x = random_signal(500, 8);
+      const reference_t reference = convolve(h, x);
+      FirFilter filter;
+      filter.setCoefficients(h.data(), h.size());
+      for (size_t n = 0; n < x.size(); n++) {
+        ASSERT_NEAR(filter.process(x[n]),
+                    reference.output[n],
+                    dot_product_bound(h.size(), reference.magnitude[n]));
+      }
+    }
+  }
+}
+
+TEST(Kernel, RtMemoryIsZeroedAlignedAndReleased)
+{
+  const RtMemoryStats before = rt_memory_stats();
+  {
+    // small enough for ordinary pages, then large enough for huge pages
+    rt_vector<double> small(1000, 0.0);
+    rt_vector<double> large(size_t {1} << 19);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small.data()) % 64, 0U);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large.data()) % 64, 0U);
+    for (double value : large) {
+      ASSERT_EQ(value, 0.0);
+    }
+    const RtMemoryStats during = rt_memory_stats();
+    EXPECT_EQ(during.regions, before.regions + 2);
+    EXPECT_GE(during.bytes, before.bytes + (sizeof(double) << 19));
+  }
+  const RtMemoryStats after = rt_memory_stats();
+  EXPECT_EQ(after.regions, before.regions);
+  EXPECT_EQ(after.unlocked, before.unlocked);
+  EXPECT_EQ(after.huge_pages, before.huge_pages);
+  EXPECT_EQ(after.bytes, before.bytes);
+}
+
+TEST(Kernel, CoefficientRegistrySharesIdenticalDesigns)
+{
+  CoefficientRegistry& registry = CoefficientRegistry::global();
+  const CoefficientRegistry::Stats before = registry.stats();
+  const std::vector<double> h = random_signal(101, 30);
+  const std::vector<double> other = random_signal(101, 31);
+  const std::vector<double> x = random_signal(300, 32);
+  {
+    FirFilter first;
+    FirFilter second;
+    FirFilter third;
+    FirFilter reference;
+    first.shareCoefficients(h.data(), h.size());
+    second.shareCoefficients(h.data(), h.size());
+    third.shareCoefficients(other.data(), other.size());
+    reference.setCoefficients(h.data(), h.size());
+
+    FilterBank bank_a;
+    FilterBank bank_b;
+    for (FilterBank* bank : {&bank_a, &bank_b}) {
+      bank->resize(2, h.size());
+      bank->setBand(0, h.data());
+      bank->setBand(1, other.data());
+      bank->share();
+    }
+
+    CoefficientRegistry::Stats during = registry.stats();
+    EXPECT_EQ(during.blocks, before.blocks + 3);
+    EXPECT_EQ(during.users, before.users + 5);
+    EXPECT_EQ(during.bytes,
+              before.bytes + 2 * h.size() * sizeof(double)
+                  + bank_a.paddedBands() * h.size() * sizeof(double));
+
+    double out_a[2];
+    double out_b[2];
+    for (double sample : x) {
+      // the same sums over the same coefficients: bit identical
+      const double y = reference.process(sample);
+      ASSERT_EQ(first.process(sample), y);
+      ASSERT_EQ(second.process(sample), y);
+      bank_a.push(sample);
+      bank_b.push(sample);
+      bank_a.compute(out_a);
+      bank_b.compute(out_b);
+      ASSERT_EQ(out_a[0], out_b[0]);
+      ASSERT_EQ(out_a[1], out_b[1]);
+    }
+
+    // a private redesign drops the reference, the block stays for the
+    // filter still sharing it
+    second.setCoefficients(other.data(), other.size());
+    during = registry.stats();
+    EXPECT_EQ(during.blocks, before.blocks + 3);
+    EXPECT_EQ(during.users, before.users + 4);
+  }
+  const CoefficientRegistry::Stats after = registry.stats();
+  EXPECT_EQ(after.blocks, before.blocks);
+  EXPECT_EQ(after.users, before.users);
+  EXPECT_EQ(after.bytes, before.bytes);
+
+  // the last release only queues the block; collect() frees it
+  const size_t regions = rt_memory_stats().regions;
+  {
+    FirFilter filter;
+    filter.shareCoefficients(h.data(), h.size());
+  }
+  EXPECT_EQ(rt_memory_stats().regions, regions + 1);
+  registry.collect();
+  EXPECT_EQ(rt_memory_stats().regions, regions);
+}
+
+TEST(Kernel, RecorderRoundTrips)
+{
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "fir-window-recorder-test";
+  // three words per frame, so the last O_DIRECT block is a partial one
+  using frame_t = std::array<uint64_t, 3>;
+  const char header[] = "RECTEST";
+
+  // a ring of 8 frames drops most of a burst before the writer wakes up
+  Recorder recorder(sizeof(frame_t), 8);
+  ASSERT_TRUE(recorder.start(path, header, sizeof(header), true));
+  EXPECT_TRUE(recorder.active());
+  const uint64_t pushed = 1000;
+  for (uint64_t n = 0; n < pushed; n++) {
+    const frame_t frame {n, n * 2, n * 3};
+    recorder.push(&frame);
+  }
+  // several frames at once go in together or not at all
+  const std::array<frame_t, 3> group {
+      {{pushed, 0, 0}, {pushed + 1, 0, 0}, {pushed + 2, 0, 0}}};
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  recorder.push(group.data(), group.size());
+  recorder.stop();
+  EXPECT_FALSE(recorder.active());
+  EXPECT_FALSE(recorder.failed());
+  EXPECT_GT(recorder.dropped(), 0U);
+
+  const uint64_t kept = pushed + group.size() - recorder.dropped();
+  ASSERT_EQ(std::filesystem::file_size(path),
+            Recorder::HEADER_BYTES + kept * sizeof(frame_t));
+  EXPECT_EQ(recorder.written(), std::filesystem::file_size(path));
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  std::vector<char> head(Recorder::HEADER_BYTES);
+  ASSERT_EQ(std::fread(head.data(), head.size(), 1, file), 1U);
+  EXPECT_STREQ(head.data(), header);
+  EXPECT_TRUE(std::all_of(head.begin() + sizeof(header),
+                          head.end(),
+                          [](char byte) { return byte == 0; }));
+  std::vector<frame_t> frames(kept);
+  ASSERT_EQ(std::fread(frames.data(), sizeof(frame_t), kept, file), kept);
+  std::fclose(file);
+  // in push order, whole frames, the group at the end
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (i > 0) {
+      EXPECT_GT(frames[i][0], frames[i - 1][0]);
+    }
+    if (frames[i][0] < pushed) {
+      EXPECT_EQ(frames[i][1], frames[i][0] * 2);
+      EXPECT_EQ(frames[i][2], frames[i][0] * 3);
+    }
+  }
+  EXPECT_EQ(frames.back()[0], pushed + 2);
+  std::filesystem::remove(path);
+}
+
+TEST(Kernel, RecorderStopsOnWriteError)
+{
+  if (!std::filesystem::exists("/dev/full")) {
+    GTEST_SKIP() << "no /dev/full";
+  }
+  using frame_t = std::array<uint64_t, 3>;
+  Recorder recorder(sizeof(frame_t), 1 << 16);
+  const char header[] = "RECTEST";
+  ASSERT_TRUE(recorder.start("/dev/full", header, sizeof(header), false));
+  // more than one batch, so the writer tries to write before stop()
+  const frame_t frame {};
+  for (size_t n = 0; n < 60000; n++) {
+    recorder.push(&frame);
+  }
+  for (int wait = 0; wait < 200 && recorder.active(); wait++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_FALSE(recorder.active());
+  EXPECT_TRUE(recorder.failed());
+  recorder.stop();
+}
+
+TEST(Kernel, PerfCountersCountFilterWork)
+{
+  // opened from another thread, as the designer thread does for the
+  // real-time thread
+  PerfCounters counters;
+  const pid_t tid = gettid();
+  size_t opened = 0;
+  std::thread([&] { opened = counters.open(tid); }).join();
+  if (opened == 0) {
+    GTEST_SKIP() << "user-space perf counters are not available here";
+  }
+  const size_t taps = 255;
+  FirFilter filter;
+  const std::vector<double> h = random_signal(taps, 3);
+  filter.setCoefficients(h.data(), h.size());
+  const std::vector<double> x = random_signal(4000, 4);
+  double sink = 0;
+  for (size_t n = 0; n < x.size(); n++) {
+    counters.begin();
+    sink += filter.process(x[n]);
+    counters.end();
+  }
+  EXPECT_TRUE(std::isfinite(sink));
+  EXPECT_LE(counters.intervals(), x.size());
+  if (counters.available(PerfCounters::INSTRUCTIONS)
+      && counters.intervals() > 0)
+  {
+    // at least a multiply-add per tap in every bracketed sample
+    EXPECT_GE(counters.totals()[PerfCounters::INSTRUCTIONS],
+              counters.intervals() * taps);
+  }
+
+  counters.reset();
+  EXPECT_EQ(counters.intervals(), 0U);
+  EXPECT_EQ(counters.totals()[PerfCounters::CYCLES], 0U);
+  counters.close();
+  EXPECT_FALSE(counters.isOpen());
+  EXPECT_FALSE(counters.available(PerfCounters::CYCLES));
+}
+
+}  // namespace
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#include "fft.hpp"
+#include "optimal_design.hpp"
+#include "tolerance_design.hpp"
+
+namespace
+{
+
+using fir_window::Tolerance;
+
+// FFT points per tap when measuring a response
+constexpr size_t MEASURE_OVERSAMPLING = 16;
+
+double passband_deviation(double ripple_db)
+{
+  const double ratio = std::pow(10.0, ripple_db / 20);
+  return (ratio - 1) / (ratio + 1);
+}
+
+double stopband_deviation(double attenuation_db)
+{
+  return std::pow(10.0, -attenuation_db / 20);
+}
+
+bool satisfies(const Tolerance& achieved, const Tolerance& wanted)
+{
+  return achieved.passband_ripple_db <= wanted.passband_ripple_db
+      && achieved.stopband_attenuation_db >= wanted.stopband_attenuation_db;
+}
+
+}  // namespace
+
+double fir_window::kaiser_beta(double attenuation_db)
+{
+  if (attenuation_db > 50) {
+    return 0.1102 * (attenuation_db - 8.7);
+  }
+  if (attenuation_db >= 21) {
+    return 0.5842 * std::pow(attenuation_db - 21, 0.4)
+        + 0.07886 * (attenuation_db - 21);
+  }
+  return 0;
+}
+
+size_t fir_window::kaiser_taps(double attenuation_db, double transition)
+{
+  const double taps =
+      (attenuation_db - 7.95) / (2.285 * M_PI * transition) + 1;
+  return odd_taps(static_cast<int64_t>(std::ceil(std::max(taps, 1.0))));
+}
+
+size_t fir_window::herrmann_taps(double passband,
+                                 double stopband,
+                                 double transition)
+{
+  // the fit was made with the larger deviation as the passband one
+  const double d1 = std::log10(std::max(passband, stopband));
+  const double d2 = std::log10(std::min(passband, stopband));
+  const double d_infinity =
+      (5.309e-3 * d1 * d1 + 7.114e-2 * d1 - 0.4761) * d2
+      + (-2.66e-3 * d1 * d1 - 0.5941 * d1 - 0.4278);
+  const double f = 11.01217 + 0.51244 * (d1 - d2);
+  const double width = transition / 2;  // cycles per sample
+  const double taps = d_infinity / width - f * width + 1;
+  return odd_taps(static_cast<int64_t>(std::ceil(std::max(taps, 1.0))));
+}
+
+fir_window::Tolerance fir_window::measure_tolerance(
+    const std::vector<double>& h, const DesignSpec& spec)
+{
+  const FftPlan plan(FftPlan::sizeFor(
+      std::max<size_t>(MEASURE_OVERSAMPLING * h.size(), 1024)));
+  std::vector<std::complex<double>> spectrum(plan.size());
+  std::copy(h.begin(), h.end(), spectrum.begin());
+  plan.forward(spectrum.data());
+
+  double passband_error = 0;
+  double stopband_gain = 0;
+  const std::vector<band_t> bands = design_bands(spec);
+  for (size_t bin = 0; bin <= plan.size() / 2; bin++) {
+    const double f = 2.0 * static_cast<double>(bin) / plan.size();
+    const double gain = std::abs(spectrum[bin]);
+    for (const auto& band : bands) {
+      if (f < band.low || f > band.high) {
+        continue;
+      }
+      if (band.desired > 0) {
+        passband_error = std::max(passband_error, std::fabs(gain - 1));
+      } else {
+        stopband_gain = std::max(stopband_gain, gain);
+      }
+    }
+  }
+
+  Tolerance achieved;
+  achieved.passband_ripple_db = passband_error < 1
+      ? 20 * std::log10((1 + passband_error) / (1 - passband_error))
+      : HUGE_VAL;
+  achieved.stopband_attenuation_db =
+      stopband_gain > 0 ? -20 * std::log10(stopband_gain) : HUGE_VAL;
+  return achieved;
+}
+
+fir_window::ToleranceFit fir_window::fit_to_tolerance(
+    const DesignSpec& base,
+    const Tolerance& tolerance,
+    size_t max_taps,
+    const Designer& designer)
+{
+  const double passband = passband_deviation(tolerance.passband_ripple_db);
+  const double stopband = stopband_deviation(tolerance.stopband_attenuation_db);
+  const double attenuation = -20 * std::log10(std::min(passband, stopband));
+
+  ToleranceFit fit;
+  fit.spec = base;
+  // minimum phase keeps the magnitude, so the search measures the cheaper
+  // linear-phase design
+  DesignSpec& spec = fit.spec;
+  spec.phase_response = LINEAR_PHASE;
+  size_t estimate = 1;
+  if (spec.method == WINDOW_METHOD) {
+    if (spec.window_shape == KAISER) {
+      spec.Kalpha = kaiser_beta(attenuation);
+    } else if (spec.window_shape == CHEBY) {
+      spec.Calpha = attenuation;
+    }
+    estimate = kaiser_taps(attenuation, spec.transition);
+  } else {
+    spec.stopband_weight = passband / stopband;
+    estimate = herrmann_taps(passband, stopband, spec.transition);
+  }
+  const auto largest = static_cast<int64_t>(std::max<size_t>(max_taps, 1));
+  const int64_t limit = largest % 2 == 0 ? largest - 1 : largest;
+  const auto check = [&](int64_t taps)
+  {
+    spec.num_taps = static_cast<size_t>(taps);
+    fit.achieved = measure_tolerance(designer(spec), spec);
+    return satisfies(fit.achieved, tolerance);
+  };
+
+  // bracket the answer between a failing (or nonexistent, -1) and a
+  // passing odd length, then bisect
+  int64_t failing = -1;
+  int64_t passing = std::min(static_cast<int64_t>(estimate), limit);
+  if (check(passing)) {
+    for (int64_t step = 2; passing > 1; step *= 2) {
+      const int64_t candidate = std::max<int64_t>(passing - step, 1);
+      if (!check(candidate)) {
+        failing = candidate;
+        break;
+      }
+      passing = candidate;
+    }
+  } else {
+    failing = passing;
+    for (int64_t step = std::max<int64_t>(passing / 4 * 2, 2);; step *= 2) {
+      const int64_t candidate = std::min(failing + step, limit);
+      if (candidate <= failing) {
+        fit.met = false;
+        spec.num_taps = static_cast<size_t>(failing);
+        spec.phase_response = base.phase_response;
+        return fit;
+      }
+      if (check(candidate)) {
+        passing = candidate;
+        break;
+      }
+      failing = candidate;
+    }
+  }
+  while (passing - failing > 2) {
+    const int64_t middle =
+        failing + std::max<int64_t>((passing - failing) / 4, 1) * 2;
+    if (check(middle)) {
+      passing = middle;
+    } else {
+      failing = middle;
+    }
+  }
+
+  check(passing);
+  fit.met = true;
+  spec.phase_response = base.phase_response;
+  return fit;
+}
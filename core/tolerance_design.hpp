@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "design.hpp"
+
+namespace fir_window
+{
+
+// Requirements on the magnitude response over the bands of a DesignSpec
+// (see design_bands()): the passband edges and stopband edges sit half a
+// transition width either side of each cutoff.
+struct Tolerance
+{
+  double passband_ripple_db = 0.1;  // peak to peak, 20 log10((1+d)/(1-d))
+  double stopband_attenuation_db = 60;  // -20 log10(largest stopband gain)
+};
+
+struct ToleranceFit
+{
+  DesignSpec spec;  // num_taps and the method's shape parameters filled in
+  bool met = false;  // false if even max_taps taps fall short
+  Tolerance achieved;
+};
+
+using Designer = std::function<std::vector<double>(const DesignSpec&)>;
+
+// Kaiser's estimates for a window design reaching attenuation_db with the
+// given transition width (fraction of Pi): the window's shape parameter
+// and the odd tap count
+double kaiser_beta(double attenuation_db);
+size_t kaiser_taps(double attenuation_db, double transition);
+
+// Herrmann, Rabiner and Chan's estimate of the odd tap count of an
+// equiripple lowpass with peak passband and stopband deviations passband
+// and stopband and the given transition width (fraction of Pi), from
+// their D-infinity fit
+size_t herrmann_taps(double passband, double stopband, double transition);
+
+// ripple and attenuation of h measured on a dense FFT grid over the bands
+// of spec
+Tolerance measure_tolerance(const std::vector<double>& h,
+                            const DesignSpec& spec);
+
+// Smallest odd tap count with which spec's method meets tolerance, at most
+// max_taps. The Kaiser window takes its beta from the tolerance and
+// Dolph-Chebyshev its attenuation; equiripple and least squares weight
+// the stopband by the ratio of the allowed errors. The search starts from
+// the Kaiser (windows) or Herrmann (optimal designs) length estimate and
+// checks every candidate by measurement. All designs go through designer,
+// so a caching designer keeps repeated fits cheap.
+ToleranceFit fit_to_tolerance(const DesignSpec& base,
+                              const Tolerance& tolerance,
+                              size_t max_taps,
+                              const Designer& designer = design_filter);
+
+}  // namespace fir_window
@@ -1,20 +1,101 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QTimer>
 
 #include "widget.hpp"
 
+#include <QGroupBox>
 #include <QLabel>
 #include <QLayout>
 #include <QPushButton>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <rtxi/rtos.hpp>
 
+// Band edges are entered as a list of fractions of Pi. Anything that is not
+// a strictly ascending sequence inside (0, 1] is dropped, and at most
+// MAX_BANDS + 1 edges are kept.
+static std::vector<double> parseBandEdges(const std::string& text)
+{
+  std::string cleaned = text;
+  std::replace(cleaned.begin(), cleaned.end(), ',', ' ');
+  std::istringstream stream(cleaned);
+  std::vector<double> edges;
+  double edge = 0;
+  while (stream >> edge && edges.size() <= fir_window::MAX_BANDS) {
+    if (edge < 0 || edge > 1 || (!edges.empty() && edge <= edges.back())) {
+      continue;
+    }
+    edges.push_back(edge);
+  }
+  return edges;
+}
+
+// CPU numbers for the helper threads; negative numbers and duplicates are
+// dropped
+static std::vector<int> parseCpuList(const std::string& text)
+{
+  std::string cleaned = text;
+  std::replace(cleaned.begin(), cleaned.end(), ',', ' ');
+  std::istringstream stream(cleaned);
+  std::vector<int> cpus;
+  int cpu = 0;
+  while (stream >> cpu) {
+    if (cpu < 0 || std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+      continue;
+    }
+    cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
 fir_window::Plugin::Plugin(Event::Manager* ev_manager)
     : Widgets::Plugin(ev_manager, std::string(fir_window::MODULE_NAME))
 {
 }
 
+RT::OS::Fifo* fir_window::Plugin::getTelemetryFifo()
+{
+  auto* component = dynamic_cast<fir_window::Component*>(getComponent());
+  return component == nullptr ? nullptr : component->getTelemetryFifo();
+}
+
+bool fir_window::Plugin::startRecording(const std::string& path)
+{
+  auto* component = dynamic_cast<fir_window::Component*>(getComponent());
+  if (component == nullptr) {
+    return false;
+  }
+  const recording_header_t header = component->describe();
+  const bool direct_io =
+      getComponentIntParameter(PARAMETER::RECORDER_DIRECT_IO) != 0;
+  return component->getRecorder().start(
+      path, &header, sizeof(header), direct_io);
+}
+
+void fir_window::Plugin::stopRecording()
+{
+  auto* component = dynamic_cast<fir_window::Component*>(getComponent());
+  if (component != nullptr) {
+    component->getRecorder().stop();
+  }
+}
+
+const fir_window::Recorder* fir_window::Plugin::getRecorder()
+{
+  auto* component = dynamic_cast<fir_window::Component*>(getComponent());
+  return component == nullptr ? nullptr : &component->getRecorder();
+}
+
 fir_window::Panel::Panel(QMainWindow* main_window, Event::Manager* ev_manager)
     : Widgets::Panel(
         std::string(fir_window::MODULE_NAME), main_window, ev_manager)
@@ -29,10 +110,21 @@ fir_window::Panel::Panel(QMainWindow* main_window, Event::Manager* ev_manager)
       "Since this plug-in computes new filter coefficients whenever you change "
       "the parameters, you should not"
       "change any settings during real-time.</p>");
+  // this is required to create the GUI
   createGUI(fir_window::get_default_vars(),
             {fir_window::WINDOW_TYPE,
-             fir_window::FILTER_TYPE});  // this is required to create the GUI
+             fir_window::FILTER_TYPE,
+             fir_window::FILTER_MODE,
+             fir_window::PHASE_RESPONSE,
+             fir_window::ENGINE,
+             fir_window::DESIGN_METHOD});
   customizeGUI();
+  telemetryTimer = new QTimer(this);
+  QObject::connect(
+      telemetryTimer, SIGNAL(timeout()), this, SLOT(readTelemetry()));
+  QObject::connect(
+      telemetryTimer, SIGNAL(timeout()), this, SLOT(refreshRecorder()));
+  telemetryTimer->start(100);
   QTimer::singleShot(0, this, SLOT(resizeMe()));
 }
 
@@ -41,61 +133,138 @@ fir_window::Component::Component(Widgets::Plugin* hplugin)
                          std::string(fir_window::MODULE_NAME),
                          fir_window::get_default_channels(),
                          fir_window::get_default_vars())
+    , recorder(sizeof(recording_frame_t), RECORDER_RING_FRAMES)
+{
+  RT::OS::getFifo(telemetry_fifo,
+                  TELEMETRY_FIFO_RECORDS * sizeof(fir_window::telemetry_t));
+  sem_init(&design_request, 0, 0);
+  designer = std::thread(&Component::designerLoop, this);
+}
+
+fir_window::Component::~Component()
 {
+  stopping.store(true);
+  sem_post(&design_request);
+  designer.join();
+  sem_destroy(&design_request);
+  // the real-time thread no longer runs this component
+  releaseRetired(nullptr);
+  delete pending.exchange(nullptr);
+  delete active;
 }
 
 void fir_window::Component::execute()
 {
   // This is the real-time function that will be called
+  if (pending.load(std::memory_order_relaxed) != nullptr) {
+    adoptFilterSet();
+  }
+  if (design_failures.load(std::memory_order_relaxed) != reported_failures) {
+    reported_failures = design_failures.load(std::memory_order_relaxed);
+    setValue<double>(PARAMETER::DESIGN_FAILURES,
+                     static_cast<double>(reported_failures));
+  }
   switch (this->getState()) {
-    case RT::State::EXEC:
-      signalin.push_back(readinput(0));
-      out = 0;
-      for (auto n = num_taps; n < 2 * num_taps; n++)
-        out += h3[n] * signalin[n];
-      writeoutput(0, out);
+    case RT::State::EXEC: {
+      periods++;
+      if (active == nullptr) {
+        // the first design is not ready yet
+        for (size_t channel = 0; channel < NUM_OUTPUTS; channel++) {
+          writeoutput(channel, 0);
+        }
+        break;
+      }
+      filter_set_t& set = *active;
+      const double input = readinput(0);
+      // the timestamps sit inside the counter reads, so switching counters
+      // on does not change the kernel time
+      if (set.counters.isOpen()) {
+        set.counters.begin();
+      }
+      const int64_t start = telemetry_decimation > 0 ? RT::OS::getTime() : 0;
+      if (set.filter_mode == FILTER_BANK) {
+        set.bank.push(input);
+        set.parallel_bank.compute(band_out.data());
+        for (size_t band = 0; band < MAX_BANDS; band++) {
+          writeoutput(band + 1, band_out[band]);
+        }
+        writeoutput(0, 0);
+        out = band_out[0];
+      } else if (set.filter_mode == ANALYTIC) {
+        // in-phase and quadrature come out of the same pass
+        set.bank.push(input);
+        set.parallel_bank.compute(band_out.data());
+        out = band_out[0];
+        band_out[2] = std::hypot(band_out[0], band_out[1]);
+        band_out[3] = std::atan2(band_out[1], band_out[0]);
+        writeoutput(0, out);
+        writeoutput(QUADRATURE_OUTPUT, band_out[1]);
+        writeoutput(AMPLITUDE_OUTPUT, band_out[2]);
+        writeoutput(PHASE_OUTPUT, band_out[3]);
+      } else if (set.filter_type == MOVING_AVERAGE) {
+        out = set.moving_average.process(input);
+        writeoutput(0, out);
+      } else if (set.engine == HYBRID_FFT) {
+        out = set.convolver.process(input);
+        writeoutput(0, out);
+        setValue<double>(PARAMETER::TAIL_DEADLINE_MISSES,
+                         static_cast<double>(set.convolver.missedDeadlines()));
+      } else {
+        if (set.modulation_interval > 0
+            && ++modulation_count >= set.modulation_interval)
+        {
+          modulation_count = 0;
+          modulateCutoff(set, readinput(1));
+        }
+        out = set.direct_filter.process(input);
+        writeoutput(0, out);
+      }
+      const int64_t kernel_ns =
+          telemetry_decimation > 0 ? RT::OS::getTime() - start : 0;
+      if (set.counters.isOpen()) {
+        set.counters.end();
+      }
+      if (set.parallel_bank.helpers() > 0) {
+        setValue<double>(
+            PARAMETER::HELPER_DEADLINE_MISSES,
+            static_cast<double>(set.parallel_bank.missedDeadlines()));
+      }
+      if (telemetry_decimation > 0) {
+        publishTelemetry(set, input, out, kernel_ns);
+      }
+      if (recorder.active()) {
+        frame.period = periods;
+        frame.input = input;
+        frame.output = set.filter_mode == FILTER_BANK ? 0 : out;
+        std::copy(band_out.begin(), band_out.end(), frame.bands);
+        recorder.push(&frame);
+      }
       break;
+    }
     case RT::State::INIT:
-      num_taps = getValue<int64_t>(PARAMETER::TAPS);
-      if (num_taps % 2 == 0) {
-        num_taps = num_taps + 1;
-      }
-
-      lambda1 = getValue<double>(PARAMETER::FREQUENCY_1);
-      lambda2 = getValue<double>(PARAMETER::FREQUENCY_2);
-      Kalpha = getValue<double>(PARAMETER::KAISER_ALPHA_ATTENUATION);
-      Calpha = getValue<double>(PARAMETER::CHEBYSHEV_ATTENUATION);
-      window_shape =
-          static_cast<window_t>(getValue<int64_t>(PARAMETER::WINDOW_TYPE));
-      filter_type =
-          static_cast<filter_t>(getValue<int64_t>(PARAMETER::FILTER_TYPE));
-      bookkeep();
-      makeFilter();
+      rt_tid = gettid();
+      loadParameters();
+      requestDesign();
       setState(RT::State::EXEC);
       break;
     case RT::State::MODIFY:
-      num_taps = getValue<int64_t>(PARAMETER::TAPS);
-      if (num_taps % 2 == 0) {
-        num_taps = num_taps + 1;
-      }
-
-      lambda1 = getValue<double>(PARAMETER::FREQUENCY_1);
-      lambda2 = getValue<double>(PARAMETER::FREQUENCY_2);
-      Kalpha = getValue<double>(PARAMETER::KAISER_ALPHA_ATTENUATION);
-      Calpha = getValue<double>(PARAMETER::CHEBYSHEV_ATTENUATION);
-      window_shape =
-          static_cast<window_t>(getValue<int64_t>(PARAMETER::WINDOW_TYPE));
-      filter_type =
-          static_cast<filter_t>(getValue<int64_t>(PARAMETER::FILTER_TYPE));
-      bookkeep();
-      makeFilter();
+      // the filters are designed on the designer thread and switched in
+      // at the start of the first period after they are ready
+      loadParameters();
+      requestDesign();
       setState(RT::State::PAUSE);
       break;
     case RT::State::PAUSE:
-      writeoutput(0, 0);
+      periods++;
+      if (feed_while_paused && active != nullptr) {
+        feedHistory(*active, readinput(0));
+      }
+      for (size_t channel = 0; channel < NUM_OUTPUTS; channel++) {
+        writeoutput(channel, 0);
+      }
       break;
     case RT::State::UNPAUSE:
-      bookkeep();
+      // the delay line is left exactly as it was when the module paused
       setState(RT::State::EXEC);
       break;
     case RT::State::PERIOD:
@@ -107,32 +276,311 @@ void fir_window::Component::execute()
   }
 }
 
-void fir_window::Component::initParameters()
+// the parameters execute() itself uses; everything that shapes the
+// filters is copied by readSettings() and handed to the designer thread
+void fir_window::Component::loadParameters()
+{
+  feed_while_paused = getValue<int64_t>(PARAMETER::FEED_WHILE_PAUSED) != 0;
+  telemetry_decimation = getValue<int64_t>(PARAMETER::TELEMETRY_DECIMATION);
+  telemetry_count = 0;
+  kernel_ns_sum = 0;
+  kernel_ns_max = 0;
+}
+
+void fir_window::Component::readSettings(design_settings_t& settings)
+{
+  settings.window_shape = getValue<int64_t>(PARAMETER::WINDOW_TYPE);
+  settings.filter_type = getValue<int64_t>(PARAMETER::FILTER_TYPE);
+  settings.num_taps = getValue<int64_t>(PARAMETER::TAPS);
+  settings.lambda1 = getValue<double>(PARAMETER::FREQUENCY_1);
+  settings.lambda2 = getValue<double>(PARAMETER::FREQUENCY_2);
+  settings.Kalpha = getValue<double>(PARAMETER::KAISER_ALPHA_ATTENUATION);
+  settings.Calpha = getValue<double>(PARAMETER::CHEBYSHEV_ATTENUATION);
+  settings.filter_mode = getValue<int64_t>(PARAMETER::FILTER_MODE);
+  settings.phase_response = getValue<int64_t>(PARAMETER::PHASE_RESPONSE);
+  settings.design_method = getValue<int64_t>(PARAMETER::DESIGN_METHOD);
+  settings.transition_width = getValue<double>(PARAMETER::TRANSITION_WIDTH);
+  settings.stopband_weight = getValue<double>(PARAMETER::STOPBAND_WEIGHT);
+  settings.taps_from_spec = getValue<int64_t>(PARAMETER::TAPS_FROM_SPEC);
+  settings.passband_ripple = getValue<double>(PARAMETER::PASSBAND_RIPPLE);
+  settings.stopband_attenuation =
+      getValue<double>(PARAMETER::STOPBAND_ATTENUATION);
+  settings.max_taps = getValue<int64_t>(PARAMETER::MAX_TAPS);
+  settings.average_stages = getValue<int64_t>(PARAMETER::AVERAGE_STAGES);
+  settings.engine = getValue<int64_t>(PARAMETER::ENGINE);
+  settings.head_taps = getValue<int64_t>(PARAMETER::HEAD_TAPS);
+  settings.modulation_interval =
+      getValue<int64_t>(PARAMETER::MODULATION_INTERVAL);
+  settings.modulation_min = getValue<double>(PARAMETER::MODULATION_MIN);
+  settings.modulation_max = getValue<double>(PARAMETER::MODULATION_MAX);
+  // the counts only reach the panel through the telemetry
+  settings.perf_counters =
+      getValue<int64_t>(PARAMETER::PERF_COUNTERS) != 0
+      && getValue<int64_t>(PARAMETER::TELEMETRY_DECIMATION) > 0;
+  settings.rt_tid = rt_tid;
+  // a longer list would not parse into more bands or helpers anyway
+  const std::string band_edges = getValue<std::string>(PARAMETER::BAND_EDGES);
+  settings.band_edges[band_edges.copy(settings.band_edges.data(),
+                                      LIST_PARAMETER_BYTES - 1)] = '\0';
+  const std::string helper_cpus =
+      getValue<std::string>(PARAMETER::HELPER_CPUS);
+  settings.helper_cpus[helper_cpus.copy(settings.helper_cpus.data(),
+                                        LIST_PARAMETER_BYTES - 1)] = '\0';
+}
+
+void fir_window::Component::requestDesign()
+{
+  readSettings(settings_slots[settings_back]);
+  settings_back =
+      settings_middle.exchange(settings_back | SETTINGS_NEW,
+                               std::memory_order_acq_rel)
+      & ~SETTINGS_NEW;
+  sem_post(&design_request);
+}
+
+// Switches execute() to the newest designed set. As when filters were
+// redesigned in place, the input history carries over to a filter or bank
+// with as many taps; that copy is the only O(taps) work here.
+void fir_window::Component::adoptFilterSet()
+{
+  filter_set_t* next = pending.exchange(nullptr, std::memory_order_acquire);
+  if (next == nullptr) {
+    return;
+  }
+  filter_set_t* previous = active;
+  active = next;
+  if (previous != nullptr) {
+    next->direct_filter.copyHistory(previous->direct_filter);
+    next->convolver.copyHistory(previous->convolver);
+    next->moving_average.copyHistory(previous->moving_average);
+    next->bank.copyHistory(previous->bank);
+    // the old helpers give their cores back now, and are joined when the
+    // designer thread frees the set
+    previous->parallel_bank.requestStop();
+    if (recorder.active()) {
+      recorder.push(next->description.data(), next->description.size());
+    }
+    previous->next_retired = retired.load(std::memory_order_relaxed);
+    while (!retired.compare_exchange_weak(previous->next_retired,
+                                          previous,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+    {
+    }
+  }
+  // wakes the designer to free the old set and then start the helpers of
+  // the new one, so the two pools never spin on the same cores
+  adopted.store(next, std::memory_order_release);
+  sem_post(&design_request);
+  modulation_count = 0;
+  // recorded frames carry band_out in every mode
+  band_out.fill(0);
+
+  setValue<double>(PARAMETER::GROUP_DELAY_SAMPLES, next->group_delay);
+  setValue<double>(
+      PARAMETER::GROUP_DELAY_MS,
+      next->group_delay * static_cast<double>(RT::OS::getPeriod()) * 1e-6);
+  setValue<double>(PARAMETER::DESIGNED_TAPS,
+                   static_cast<double>(next->num_taps));
+  setValue<double>(PARAMETER::SPEC_MET, next->spec_met ? 1.0 : 0.0);
+  setValue<double>(PARAMETER::MODULATION_ERROR, next->modulation_error);
+  setValue<double>(PARAMETER::HELPER_DEADLINE_MISSES, 0.0);
+  setValue<double>(PARAMETER::UNLOCKED_BUFFERS,
+                   static_cast<double>(next->memory.unlocked));
+  setValue<double>(PARAMETER::HUGE_PAGE_BUFFERS,
+                   static_cast<double>(next->memory.huge_pages));
+  setValue<double>(PARAMETER::SHARED_BLOCKS,
+                   static_cast<double>(next->shared.blocks));
+  setValue<double>(PARAMETER::SHARED_USERS,
+                   static_cast<double>(next->shared.users));
+}
+
+// Designs run here, below the real-time thread, so an equiripple fit that
+// takes a second only delays the switch to the new filters instead of
+// stalling execute(). The thread also frees what execute() let go of.
+void fir_window::Component::designerLoop()
+{
+  while (!stopping.load()) {
+    timespec deadline {};
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += DESIGNER_POLL_NS;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000;
+    deadline.tv_nsec %= 1000000000;
+    sem_timedwait(&design_request, &deadline);
+    // the set adopted first, since execute() retires the set it replaces
+    // before announcing the new one
+    filter_set_t* adopted_set =
+        adopted.exchange(nullptr, std::memory_order_acquire);
+    adopted_set = releaseRetired(adopted_set);
+    if (adopted_set != nullptr) {
+      startHelpers(*adopted_set);
+    }
+    CoefficientRegistry::global().collect();
+    if (stopping.load()
+        || (settings_middle.load(std::memory_order_relaxed) & SETTINGS_NEW)
+            == 0)
+    {
+      continue;
+    }
+    settings_front = settings_middle.exchange(settings_front,
+                                              std::memory_order_acq_rel)
+        & ~SETTINGS_NEW;
+    std::unique_ptr<filter_set_t> set;
+    try {
+      set = buildFilterSet(settings_slots[settings_front]);
+    } catch (const std::bad_alloc&) {
+      // whatever was built is freed again and the running set stays
+      design_failures.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    } catch (const std::invalid_argument&) {
+      // settings no design fits, such as a passband narrower than the
+      // transition band of an equiripple fit
+      design_failures.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    {
+      const std::scoped_lock lock(header_mutex);
+      header = describe(*set);
+      std::memcpy(set->description.data(), &header, sizeof(header));
+    }
+    // a set execute() has not picked up yet is superseded
+    delete pending.exchange(set.release(), std::memory_order_acq_rel);
+  }
+}
+
+// Frees the sets execute() let go of and returns adopted_set, or null if
+// it was one of them because execute() has already moved on.
+fir_window::filter_set_t* fir_window::Component::releaseRetired(
+    filter_set_t* adopted_set)
+{
+  filter_set_t* set = retired.exchange(nullptr, std::memory_order_acquire);
+  while (set != nullptr) {
+    filter_set_t* next = set->next_retired;
+    if (set == adopted_set) {
+      adopted_set = nullptr;
+    }
+    // joins the set's helper threads
+    delete set;
+    set = next;
+  }
+  return adopted_set;
+}
+
+std::unique_ptr<fir_window::filter_set_t>
+fir_window::Component::buildFilterSet(const design_settings_t& settings)
+{
+  auto set = std::make_unique<filter_set_t>();
+  loadSettings(*set, settings);
+  fitToSpec(*set);
+  makeFilter(*set);
+  makeFilterBank(*set);
+  makeAnalyticFilter(*set);
+  attachBank(*set);
+  openCounters(*set, settings);
+  makeCutoffTable(*set);
+  reportGroupDelay(*set);
+  reportMemory(*set);
+  return set;
+}
+
+void fir_window::Component::loadSettings(filter_set_t& set,
+                                         const design_settings_t& settings)
 {
-  dt = RT::OS::getPeriod() * 1e-9;  // s
-  signalin.clear();
-  assert(signalin.empty());
-  window_shape = HAMM;
-  filter_type = BANDPASS;
-  num_taps = 9;
-  lambda1 = 0.1;  // Hz / pi
-  lambda2 = 0.6;  // Hz / pi
-  Calpha = 70;  // dB
-  Kalpha = 1.5;
-  makeFilter();
-  bookkeep();
+  set.num_taps = static_cast<int64_t>(odd_taps(settings.num_taps));
+
+  set.lambda1 = settings.lambda1;
+  set.lambda2 = settings.lambda2;
+  set.Kalpha = settings.Kalpha;
+  set.Calpha = settings.Calpha;
+  set.window_shape = static_cast<window_t>(settings.window_shape);
+  set.filter_type = static_cast<filter_t>(settings.filter_type);
+  set.filter_mode = static_cast<filter_mode_t>(settings.filter_mode);
+  set.phase_response = static_cast<phase_t>(settings.phase_response);
+  set.average_stages =
+      std::clamp<int64_t>(settings.average_stages,
+                          1,
+                          static_cast<int64_t>(MovingAverage::MAX_STAGES));
+  // a running sum has no Type I restriction, any length works
+  if (set.filter_mode == SINGLE && set.filter_type == MOVING_AVERAGE) {
+    set.num_taps = std::max<int64_t>(settings.num_taps, 1);
+  }
+  set.design_method = static_cast<method_t>(settings.design_method);
+  // a transition band must fit between the band edges it separates
+  set.transition_width = std::clamp(settings.transition_width, 1e-4, 0.5);
+  set.stopband_weight = std::max(settings.stopband_weight, 1e-6);
+  set.taps_from_spec = settings.taps_from_spec != 0;
+  set.tolerance.passband_ripple_db = std::max(settings.passband_ripple, 1e-4);
+  set.tolerance.stopband_attenuation_db =
+      std::max(settings.stopband_attenuation, 1.0);
+  set.max_taps = std::max<int64_t>(settings.max_taps, 1);
+  set.engine = static_cast<engine_t>(settings.engine);
+  set.head_taps = std::max<int64_t>(settings.head_taps, 2);
+  set.modulation_interval = settings.modulation_interval;
+  set.modulation_min = settings.modulation_min;
+  set.modulation_max = settings.modulation_max;
+  set.band_edges = parseBandEdges(settings.band_edges.data());
+  // a bank needs at least one band; without it the module runs one filter
+  if (set.filter_mode == FILTER_BANK && set.band_edges.size() < 2) {
+    set.filter_mode = SINGLE;
+  }
+  set.helper_cpus = parseCpuList(settings.helper_cpus.data());
 }
 
-void fir_window::Component::bookkeep()
+void fir_window::Component::publishTelemetry(filter_set_t& set,
+                                             double input,
+                                             double output,
+                                             int64_t kernel_ns)
 {
-  signalin.set_capacity(2 * num_taps);
-  convolution = new double[num_taps];
-  for (int i = 0; i < 2 * num_taps; i++)
-    signalin.push_back(0);  // pad with zeros
+  kernel_ns_sum += kernel_ns;
+  kernel_ns_max = std::max(kernel_ns_max, kernel_ns);
+  if (++telemetry_count < telemetry_decimation) {
+    return;
+  }
+
+  telemetry_t record {};
+  record.time = RT::OS::getTime();
+  record.input = input;
+  record.output = output;
+  record.kernel_mean_ns = static_cast<double>(kernel_ns_sum)
+      / static_cast<double>(telemetry_count);
+  record.kernel_max_ns = kernel_ns_max;
+  record.dropped = telemetry_dropped;
+  PerfCounters& counters = set.counters;
+  if (counters.isOpen() && counters.intervals() > 0) {
+    const auto intervals = static_cast<double>(counters.intervals());
+    for (size_t event = 0; event < PerfCounters::NUM_EVENTS; event++) {
+      if (counters.available(static_cast<PerfCounters::event_t>(event))) {
+        record.counters_valid |= 1U << event;
+        record.counters[event] =
+            static_cast<double>(counters.totals()[event]) / intervals;
+      }
+    }
+    counters.reset();
+  }
+  // writeRT never blocks; a full fifo just costs this record
+  if (telemetry_fifo == nullptr
+      || telemetry_fifo->writeRT(&record, sizeof(record))
+          != static_cast<int64_t>(sizeof(record)))
+  {
+    telemetry_dropped++;
+  }
+  telemetry_count = 0;
+  kernel_ns_sum = 0;
+  kernel_ns_max = 0;
+}
 
-  assert(signalin.full());  // check size and padding
-  assert(signalin.size() == 2 * num_taps);
-  assert(signalin.capacity() == 2 * num_taps);
+// keeps the active delay line current while the outputs are paused
+void fir_window::Component::feedHistory(filter_set_t& set, double input)
+{
+  if (set.filter_mode == FILTER_BANK || set.filter_mode == ANALYTIC) {
+    set.bank.push(input);
+  } else if (set.filter_type == MOVING_AVERAGE) {
+    set.moving_average.process(input);
+  } else if (set.engine == HYBRID_FFT) {
+    set.convolver.process(input);
+  } else {
+    set.direct_filter.push(input);
+  }
 }
 
 void fir_window::Panel::updateWindow(int index)
@@ -155,38 +603,460 @@ void fir_window::Panel::updateFilterType(int index)
                                  static_cast<int64_t>(index));
 }
 
-void fir_window::Component::makeFilter()
+void fir_window::Panel::updateFilterMode(int index)
 {
-  switch (window_shape) {
-    case RECT:  // rectangular
-      disc_window = new RectangularWindow(num_taps);
-      break;
+  if (index < 0) {
+    return;
+  }
+  Widgets::Plugin* hplugin = getHostPlugin();
+  hplugin->setComponentParameter(fir_window::FILTER_MODE,
+                                 static_cast<int64_t>(index));
+}
 
-    case TRI:  // triangular
-      disc_window = new TriangularWindow(num_taps, 1);
-      break;
+fir_window::recording_header_t fir_window::Component::describe()
+{
+  const std::scoped_lock lock(header_mutex);
+  return header;
+}
 
-    case HAMM:  // Hamming
-      disc_window = new HammingWindow(num_taps);
-      break;
+fir_window::recording_header_t fir_window::Component::describe(
+    const filter_set_t& set) const
+{
+  recording_header_t description {};
+  std::copy_n("FIRWREC", sizeof(description.magic), description.magic);
+  description.version = 5;
+  description.frame_bytes = sizeof(recording_frame_t);
+  description.period = RT::OS::getPeriod() * 1e-9;
+  description.window_shape = set.window_shape;
+  description.filter_type = set.filter_type;
+  description.filter_mode = set.filter_mode;
+  description.phase_response = set.phase_response;
+  description.num_taps = set.num_taps;
+  description.lambda1 = set.lambda1;
+  description.lambda2 = set.lambda2;
+  description.Kalpha = set.Kalpha;
+  description.Calpha = set.Calpha;
+  description.num_band_edges = set.band_edges.size();
+  std::copy(
+      set.band_edges.begin(), set.band_edges.end(), description.band_edges);
+  description.design_method = set.design_method;
+  description.transition_width = set.transition_width;
+  description.stopband_weight = set.stopband_weight;
+  description.average_stages = set.average_stages;
+  description.description_frames = DESCRIPTION_FRAMES;
+  return description;
+}
 
-    case HANN:  // Hann
-      disc_window = new HannWindow(num_taps, 1);
-      break;
+void fir_window::Panel::readTelemetry()
+{
+  auto* hplugin = dynamic_cast<fir_window::Plugin*>(getHostPlugin());
+  RT::OS::Fifo* fifo =
+      hplugin == nullptr ? nullptr : hplugin->getTelemetryFifo();
+  if (fifo == nullptr) {
+    return;
+  }
 
-    case CHEBY:  // Dolph-Chebyshev
-      disc_window = new DolphChebyWindow(num_taps, Calpha);
-      break;
+  // drain everything queued since the last tick, only the newest is shown
+  telemetry_t record {};
+  bool received = false;
+  while (fifo->read(&record, sizeof(record))
+         == static_cast<int64_t>(sizeof(record)))
+  {
+    received = true;
+  }
+  if (!received) {
+    return;
+  }
+  telemetryInput->setText(QString::number(record.input));
+  telemetryOutput->setText(QString::number(record.output));
+  telemetryKernel->setText(
+      QString("%1 / %2 us")
+          .arg(record.kernel_mean_ns * 1e-3, 0, 'f', 2)
+          .arg(static_cast<double>(record.kernel_max_ns) * 1e-3, 0, 'f', 2));
+  telemetryDropped->setText(QString::number(record.dropped));
+  for (size_t event = 0; event < PerfCounters::NUM_EVENTS; event++) {
+    if ((record.counters_valid & (1U << event)) == 0) {
+      telemetryCounters[event]->setText("-");
+      continue;
+    }
+    QString text = QString::number(record.counters[event], 'f', 1);
+    // instructions per cycle is the first thing to look at
+    if (event == PerfCounters::INSTRUCTIONS
+        && (record.counters_valid & (1U << PerfCounters::CYCLES)) != 0
+        && record.counters[PerfCounters::CYCLES] > 0)
+    {
+      text += QString(" (%1 IPC)").arg(
+          record.counters[event] / record.counters[PerfCounters::CYCLES],
+          0,
+          'f',
+          2);
+    }
+    telemetryCounters[event]->setText(text);
+  }
+}
 
-    case KAISER:
-      disc_window = new KaiserWindow(num_taps, Kalpha);
-      break;
-  }  // end of switch on window_shape
+void fir_window::Panel::toggleRecording(bool enable)
+{
+  auto* hplugin = dynamic_cast<fir_window::Plugin*>(getHostPlugin());
+  if (hplugin == nullptr) {
+    return;
+  }
+  if (!enable) {
+    hplugin->stopRecording();
+    recordButton->setText("Start Recording");
+    return;
+  }
+
+  const QString fileName = QFileDialog::getSaveFileName(
+      this, "Record filter input/output", "", "FIR recordings (*.firrec)");
+  if (fileName.isEmpty() || !hplugin->startRecording(fileName.toStdString()))
+  {
+    if (!fileName.isEmpty()) {
+      QMessageBox::information(this,
+                               "FIR filter: Record input/output",
+                               "There was an error opening this file.\n");
+    }
+    recordButton->setChecked(false);
+    return;
+  }
+  recordButton->setText("Stop Recording");
+}
+
+void fir_window::Panel::refreshRecorder()
+{
+  auto* hplugin = dynamic_cast<fir_window::Plugin*>(getHostPlugin());
+  const Recorder* recorder =
+      hplugin == nullptr ? nullptr : hplugin->getRecorder();
+  if (recorder == nullptr || !recorder->active()) {
+    // the writer gives up on a write error; release the button with it
+    if (recordButton->isChecked()) {
+      recordButton->setChecked(false);
+    }
+    recorderStatus->setText(recorder != nullptr && recorder->failed()
+                                ? "Not recording (write error)"
+                                : "Not recording");
+    return;
+  }
+  recorderStatus->setText(QString("%1 MB written, %2 frames dropped%3")
+                              .arg(recorder->written() * 1e-6, 0, 'f', 1)
+                              .arg(recorder->dropped())
+                              .arg(recorder->failed() ? ", write error" : ""));
+}
+
+void fir_window::Panel::updatePhaseResponse(int index)
+{
+  if (index < 0) {
+    return;
+  }
+  Widgets::Plugin* hplugin = getHostPlugin();
+  hplugin->setComponentParameter(fir_window::PHASE_RESPONSE,
+                                 static_cast<int64_t>(index));
+}
+
+void fir_window::Panel::updateDesignMethod(int index)
+{
+  if (index < 0) {
+    return;
+  }
+  Widgets::Plugin* hplugin = getHostPlugin();
+  hplugin->setComponentParameter(fir_window::DESIGN_METHOD,
+                                 static_cast<int64_t>(index));
+}
+
+void fir_window::Panel::updateEngine(int index)
+{
+  if (index < 0) {
+    return;
+  }
+  Widgets::Plugin* hplugin = getHostPlugin();
+  hplugin->setComponentParameter(fir_window::ENGINE,
+                                 static_cast<int64_t>(index));
+}
+
+fir_window::DesignSpec fir_window::Component::designSpec(
+    const filter_set_t& set, double low, double high, filter_t type) const
+{
+  DesignSpec spec;
+  spec.window_shape = set.window_shape;
+  spec.filter_type = type;
+  spec.num_taps = static_cast<size_t>(set.num_taps);
+  spec.lambda1 = low;
+  spec.lambda2 = high;
+  spec.Kalpha = set.Kalpha;
+  spec.Calpha = set.Calpha;
+  spec.phase_response = set.phase_response;
+  spec.method = set.design_method;
+  spec.transition = set.transition_width;
+  spec.stopband_weight = set.stopband_weight;
+  return spec;
+}
+
+// Replaces the tap count, and the window or weight parameters the chosen
+// method needs, with the cheapest ones that meet the tolerance. A filter
+// bank uses the longest length any of its bands needs.
+void fir_window::Component::fitToSpec(filter_set_t& set)
+{
+  set.spec_met = false;
+  if (!set.taps_from_spec) {
+    return;
+  }
+  std::vector<DesignSpec> targets;
+  if (set.filter_mode == FILTER_BANK) {
+    for (size_t band = 0; band + 1 < set.band_edges.size(); band++) {
+      targets.push_back(designSpec(
+          set, set.band_edges[band], set.band_edges[band + 1], BANDPASS));
+    }
+  } else if (set.filter_mode == ANALYTIC) {
+    targets.push_back(designSpec(set,
+                                 std::min(set.lambda1, set.lambda2),
+                                 std::max(set.lambda1, set.lambda2),
+                                 BANDPASS));
+    targets.back().method = WINDOW_METHOD;
+  } else if (set.filter_type != MOVING_AVERAGE) {
+    targets.push_back(
+        designSpec(set, set.lambda1, set.lambda2, set.filter_type));
+  }
+  if (targets.empty()) {
+    // a moving average has no ripple or stopband to meet
+    return;
+  }
+
+  // the cache keeps the outcome of each search and the final designs, not
+  // every candidate. The bands of a bank are fitted concurrently.
+  std::vector<std::future<ToleranceFit>> fits;
+  for (const auto& target : targets) {
+    fits.push_back(std::async(
+        std::launch::async,
+        [this, &target, &set]
+        {
+          return cache.fit(
+              target, set.tolerance, static_cast<size_t>(set.max_taps));
+        }));
+  }
+  size_t longest = 1;
+  bool met = true;
+  for (auto& pending_fit : fits) {
+    const ToleranceFit fit = pending_fit.get();
+    longest = std::max(longest, fit.spec.num_taps);
+    met = met && fit.met;
+    // shape parameters depend on the tolerance only, not on the band
+    set.Kalpha = fit.spec.Kalpha;
+    set.Calpha = fit.spec.Calpha;
+    if (set.filter_mode != ANALYTIC) {
+      set.stopband_weight = fit.spec.stopband_weight;
+    }
+  }
+  set.num_taps = static_cast<int64_t>(longest);
+  set.spec_met = met;
+}
+
+void fir_window::Component::makeFilter(filter_set_t& set)
+{
+  if (set.filter_mode != SINGLE) {
+    return;
+  }
+  if (set.filter_type == MOVING_AVERAGE) {
+    // no taps: the running sums are the whole filter
+    set.moving_average.configure(static_cast<size_t>(set.num_taps),
+                                 static_cast<size_t>(set.average_stages));
+    return;
+  }
+  // instances with the same design share one copy of it
+  set.coefficients = CoefficientRegistry::global().publish(
+      cache.design(designSpec(set, set.lambda1, set.lambda2, set.filter_type)));
+  const SharedCoefficients& h = set.coefficients;
+  if (set.engine == HYBRID_FFT) {
+    // the direct filter stays empty: it would never see the input, and a
+    // later switch back to it must not take over history from back then
+    set.convolver.configure(
+        h->data(), h->size(), static_cast<size_t>(set.head_taps));
+  } else if (set.modulation_interval > 0) {
+    // modulation rewrites the taps in place from execute()
+    set.direct_filter.setCoefficients(h->data(), h->size());
+  } else {
+    set.direct_filter.shareCoefficients(h->data(), h->size());
+  }
+}
+
+void fir_window::Component::makeFilterBank(filter_set_t& set)
+{
+  if (set.filter_mode != FILTER_BANK) {
+    return;
+  }
+
+  // every band shares the tap count and window so that one delay line and
+  // one pass over it serve the whole bank
+  const std::vector<double>& edges = set.band_edges;
+  const size_t num_bands = edges.size() - 1;
+  // an equiripple or least squares band can take a while, so the bands
+  // are designed concurrently
+  std::vector<std::future<std::vector<double>>> designs;
+  for (size_t band = 0; band < num_bands; band++) {
+    designs.push_back(std::async(
+        std::launch::async,
+        [this, spec = designSpec(set, edges[band], edges[band + 1], BANDPASS)]
+        { return cache.design(spec); }));
+  }
+  set.bank.resize(num_bands, static_cast<size_t>(set.num_taps));
+  for (size_t band = 0; band < num_bands; band++) {
+    const std::vector<double> h = designs[band].get();
+    set.bank.setBand(band, h.data());
+    if (band == 0) {
+      set.group_delay = group_delay(
+          h.data(), h.size(), passbandCentre(edges[0], edges[1], BANDPASS));
+    }
+  }
+  set.bank.share();
+}
+
+// The bandpass filter and its antisymmetric Hilbert partner share window,
+// length and delay, so I and Q are aligned sample for sample.
+void fir_window::Component::makeAnalyticFilter(filter_set_t& set)
+{
+  if (set.filter_mode != ANALYTIC) {
+    return;
+  }
+  DesignSpec spec = designSpec(set,
+                               std::min(set.lambda1, set.lambda2),
+                               std::max(set.lambda1, set.lambda2),
+                               BANDPASS);
+  // the Hilbert partner only exists for the window method
+  spec.phase_response = LINEAR_PHASE;
+  spec.method = WINDOW_METHOD;
+  const std::vector<double> in_phase = cache.design(spec);
+  const std::vector<double> quadrature =
+      cache.design(spec, CoefficientCache::QUADRATURE);
+  set.bank.resize(2, spec.num_taps);
+  set.bank.setBand(0, in_phase.data());
+  set.bank.setBand(1, quadrature.data());
+  set.bank.share();
+}
+
+// Helpers get half a period to deliver before the real-time thread takes
+// their share back.
+void fir_window::Component::attachBank(filter_set_t& set)
+{
+  if (set.filter_mode != FILTER_BANK && set.filter_mode != ANALYTIC) {
+    return;
+  }
+  set.parallel_bank.attach(&set.bank, RT::OS::getPeriod() / 2);
+}
+
+// Helpers spin for the whole time the set runs, so they are only worth
+// their cores when the bank is long; ParallelBank runs inline otherwise.
+// They start once execute() runs the set and the helpers of the set before
+// it have been joined.
+void fir_window::Component::startHelpers(filter_set_t& set)
+{
+  if (set.filter_mode != FILTER_BANK && set.filter_mode != ANALYTIC) {
+    return;
+  }
+  set.parallel_bank.start(set.helper_cpus);
+}
+
+// Opened here rather than in execute(), which only reads them through
+// their mapped pages.
+void fir_window::Component::openCounters(filter_set_t& set,
+                                         const design_settings_t& settings)
+{
+  if (settings.perf_counters != 0 && settings.rt_tid > 0) {
+    set.counters.open(static_cast<pid_t>(settings.rt_tid));
+  }
+}
+
+// Modulation only drives the direct single filter: the table holds
+// linear-phase window method prototypes, and the hybrid engine and the
+// filter bank cannot swap coefficients within one period.
+void fir_window::Component::makeCutoffTable(filter_set_t& set)
+{
+  if (set.modulation_interval <= 0 || set.filter_mode != SINGLE
+      || set.engine != DIRECT || set.phase_response != LINEAR_PHASE
+      || set.design_method != WINDOW_METHOD
+      || set.filter_type == MOVING_AVERAGE)
+  {
+    set.modulation_interval = 0;
+    return;
+  }
+  // bandpass/bandstop keep their width and move their centre, so the
+  // table must reach half a band beyond the modulation range
+  double margin = 0;
+  if (set.filter_type == BANDPASS || set.filter_type == BANDSTOP) {
+    margin = std::fabs(set.lambda2 - set.lambda1) / 2;
+  }
+  set.cutoff_table.build(
+      designSpec(set, set.lambda1, set.lambda2, set.filter_type),
+      set.modulation_min - margin,
+      set.modulation_max + margin);
+  set.modulated.assign(set.cutoff_table.taps(), 0.0);
+  set.modulation_error = set.cutoff_table.interpolationError();
+}
 
-  filter_design = new FirIdealFilter(num_taps, lambda1, lambda2, filter_type);
-  //	h2 = filter_design->GetCoefficients();
-  filter_design->ApplyWindow(disc_window);
-  h3 = filter_design->GetCoefficients();
+void fir_window::Component::modulateCutoff(filter_set_t& set, double control)
+{
+  const double cutoff =
+      std::clamp(control,
+                 std::min(set.modulation_min, set.modulation_max),
+                 std::max(set.modulation_min, set.modulation_max));
+  const double half_width = std::fabs(set.lambda2 - set.lambda1) / 2;
+  if (set.filter_type == BANDPASS || set.filter_type == BANDSTOP) {
+    set.cutoff_table.design(set.filter_type,
+                            cutoff - half_width,
+                            cutoff + half_width,
+                            set.modulated.data());
+  } else {
+    set.cutoff_table.design(
+        set.filter_type, cutoff, cutoff, set.modulated.data());
+  }
+  set.direct_filter.setCoefficients(set.modulated.data(),
+                                    set.modulated.size());
+  setValue<double>(PARAMETER::MODULATED_CUTOFF, cutoff);
+}
+
+// normalized frequency (rad/sample) at which the group delay is reported
+double fir_window::Component::passbandCentre(double low,
+                                             double high,
+                                             filter_t type) const
+{
+  switch (type) {
+    case HIGHPASS:
+      return M_PI;
+    case BANDPASS:
+      return M_PI * (low + high) / 2;
+    case LOWPASS:
+    case BANDSTOP:
+    case MOVING_AVERAGE:
+    default:
+      return 0;
+  }
+}
+
+void fir_window::Component::reportGroupDelay(filter_set_t& set)
+{
+  if (set.filter_mode == FILTER_BANK) {
+    // taken from the first band when the bank was designed
+    return;
+  }
+  if (set.filter_mode == ANALYTIC) {
+    // both rows are linear phase
+    set.group_delay = static_cast<double>(set.num_taps - 1) / 2;
+    return;
+  }
+  if (set.filter_type == MOVING_AVERAGE) {
+    set.group_delay = set.moving_average.groupDelay();
+    return;
+  }
+  set.group_delay =
+      group_delay(set.coefficients->data(),
+                  set.coefficients->size(),
+                  passbandCentre(set.lambda1, set.lambda2, set.filter_type));
+}
+
+// The counts cover every fir-window instance in the process, since they
+// all allocate real-time buffers from the same pool of locked mappings.
+void fir_window::Component::reportMemory(filter_set_t& set)
+{
+  set.memory = rt_memory_stats();
+  set.shared = CoefficientRegistry::global().stats();
 }
 
 void fir_window::Panel::saveFIRData()
@@ -226,6 +1096,12 @@ void fir_window::Panel::saveFIRData()
           stream << QString("BANDSTOP lambda1=") << (double)lambda1
                  << " lambda2= " << (double)lambda2;
           break;
+
+        case MOVING_AVERAGE:
+          stream << QString("MOVING_AVERAGE stages=")
+                 << hplugin->getComponentIntParameter(
+                        PARAMETER::AVERAGE_STAGES);
+          break;
       }
       int64_t window_shape =
           hplugin->getComponentIntParameter(PARAMETER::WINDOW_TYPE);
@@ -326,6 +1202,17 @@ void fir_window::Panel::customizeGUI()
   saveDataButton->setToolTip(
       "Save filter parameters and coefficients to a file");
 
+  recordButton = new QPushButton("Start Recording");
+  recordButton->setCheckable(true);
+  recordButton->setToolTip(
+      "Stream the filter input and outputs to a binary file, preceded by a "
+      "header describing the filter");
+  boxLayout->addWidget(recordButton);
+  QObject::connect(
+      recordButton, SIGNAL(toggled(bool)), this, SLOT(toggleRecording(bool)));
+  recorderStatus = new QLabel("Not recording");
+  boxLayout->addWidget(recorderStatus);
+
   QWidget* optionBox = new QWidget;
   QGridLayout* optionBoxLayout = new QGridLayout;
   optionBox->setLayout(optionBoxLayout);
@@ -348,16 +1235,106 @@ void fir_window::Panel::customizeGUI()
 
   QLabel* filterLabel = new QLabel("Type of Filter:");
   filterType = new QComboBox;
-  filterType->setToolTip("A Type 1 FIR filter.");
+  filterType->setToolTip(
+      "A Type 1 FIR filter, or a moving average run as a running sum.");
   filterType->insertItem(1, "Lowpass");
   filterType->insertItem(2, "Highpass");
   filterType->insertItem(3, "Bandpass");
   filterType->insertItem(4, "Bandstop");
+  filterType->insertItem(5, "Moving Average");
   optionBoxLayout->addWidget(filterLabel, 1, 0);
   optionBoxLayout->addWidget(filterType, 1, 1);
   QObject::connect(
       filterType, SIGNAL(activated(int)), this, SLOT(updateFilterType(int)));
 
+  QLabel* modeLabel = new QLabel("Filter Mode:");
+  filterMode = new QComboBox;
+  filterMode->setToolTip(
+      "Filter Bank applies one bandpass filter per pair of band edges over a "
+      "shared delay line and writes each band to its own output. Analytic "
+      "Signal bandpasses Frequency 1-2 and outputs in-phase, quadrature, "
+      "amplitude and phase.");
+  filterMode->insertItem(1, "Single Filter");
+  filterMode->insertItem(2, "Filter Bank");
+  filterMode->insertItem(3, "Analytic Signal");
+  optionBoxLayout->addWidget(modeLabel, 2, 0);
+  optionBoxLayout->addWidget(filterMode, 2, 1);
+  QObject::connect(
+      filterMode, SIGNAL(activated(int)), this, SLOT(updateFilterMode(int)));
+
+  QLabel* phaseLabel = new QLabel("Phase Response:");
+  phaseResponse = new QComboBox;
+  phaseResponse->setToolTip(
+      "Minimum phase keeps the magnitude response but moves the group delay "
+      "from (taps - 1) / 2 to a few samples. Phase is no longer linear.");
+  phaseResponse->insertItem(1, "Linear Phase");
+  phaseResponse->insertItem(2, "Minimum Phase");
+  optionBoxLayout->addWidget(phaseLabel, 3, 0);
+  optionBoxLayout->addWidget(phaseResponse, 3, 1);
+  QObject::connect(phaseResponse,
+                   SIGNAL(activated(int)),
+                   this,
+                   SLOT(updatePhaseResponse(int)));
+
+  QLabel* methodLabel = new QLabel("Design Method:");
+  designMethod = new QComboBox;
+  designMethod->setToolTip(
+      "Equiripple (Parks-McClellan) and least squares designs meet a given "
+      "ripple with fewer taps than a window. They use Transition Width and "
+      "Stopband Weight instead of the window shape.");
+  designMethod->insertItem(1, "Window");
+  designMethod->insertItem(2, "Equiripple");
+  designMethod->insertItem(3, "Least Squares");
+  optionBoxLayout->addWidget(methodLabel, 5, 0);
+  optionBoxLayout->addWidget(designMethod, 5, 1);
+  QObject::connect(designMethod,
+                   SIGNAL(activated(int)),
+                   this,
+                   SLOT(updateDesignMethod(int)));
+
+  QLabel* engineLabel = new QLabel("Convolution Engine:");
+  convolutionEngine = new QComboBox;
+  convolutionEngine->setToolTip(
+      "Hybrid FFT convolves the first Head Taps directly and the rest by "
+      "FFT on a helper thread, with no added latency. Use it for long "
+      "filters in single filter mode.");
+  convolutionEngine->insertItem(1, "Direct");
+  convolutionEngine->insertItem(2, "Hybrid FFT");
+  optionBoxLayout->addWidget(engineLabel, 4, 0);
+  optionBoxLayout->addWidget(convolutionEngine, 4, 1);
+  QObject::connect(
+      convolutionEngine, SIGNAL(activated(int)), this, SLOT(updateEngine(int)));
+
+  QGroupBox* telemetryBox = new QGroupBox("Telemetry");
+  QGridLayout* telemetryLayout = new QGridLayout;
+  telemetryBox->setLayout(telemetryLayout);
+  telemetryBox->setToolTip(
+      "Decimated input/output samples and kernel timing streamed from the "
+      "real-time thread. Set Telemetry Decimation to 0 to disable.");
+  telemetryInput = new QLabel("-");
+  telemetryOutput = new QLabel("-");
+  telemetryKernel = new QLabel("-");
+  telemetryDropped = new QLabel("0");
+  telemetryLayout->addWidget(new QLabel("Input:"), 0, 0);
+  telemetryLayout->addWidget(telemetryInput, 0, 1);
+  telemetryLayout->addWidget(new QLabel("Output:"), 1, 0);
+  telemetryLayout->addWidget(telemetryOutput, 1, 1);
+  telemetryLayout->addWidget(new QLabel("Kernel mean / max:"), 2, 0);
+  telemetryLayout->addWidget(telemetryKernel, 2, 1);
+  telemetryLayout->addWidget(new QLabel("Dropped records:"), 3, 0);
+  telemetryLayout->addWidget(telemetryDropped, 3, 1);
+  for (size_t event = 0; event < PerfCounters::NUM_EVENTS; event++) {
+    const auto row = static_cast<int>(4 + event);
+    telemetryCounters[event] = new QLabel("-");
+    telemetryLayout->addWidget(
+        new QLabel(QString("%1 / period:").arg(
+            PerfCounters::name(static_cast<PerfCounters::event_t>(event)))),
+        row,
+        0);
+    telemetryLayout->addWidget(telemetryCounters[event], row, 1);
+  }
+  boxLayout->addWidget(telemetryBox);
+
   widget_layout->insertWidget(0, box);
   setLayout(widget_layout);
 }
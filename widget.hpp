@@ -1,21 +1,39 @@
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <QComboBox>
 #include <QFile>
+#include <QLabel>
+#include <QPushButton>
 #include <QTextStream>
+#include <QTimer>
 
-#include <boost/circular_buffer.hpp>
-#include <rtxi/dsp/dolph.h>
-#include <rtxi/dsp/fir_dsgn.h>
-#include <rtxi/dsp/firideal.h>
-#include <rtxi/dsp/gen_win.h>
-#include <rtxi/dsp/hamming.h>
-#include <rtxi/dsp/hann.h>
-#include <rtxi/dsp/kaiser.h>
-#include <rtxi/dsp/lin_dsgn.h>
-#include <rtxi/dsp/rectnglr.h>
-#include <rtxi/dsp/trianglr.h>
+#include <rtxi/fifo.hpp>
 #include <rtxi/widgets.hpp>
 
+#include "coefficient_cache.hpp"
+#include "coefficient_registry.hpp"
+#include "cutoff_table.hpp"
+#include "design.hpp"
+#include "filter_bank.hpp"
+#include "fir_filter.hpp"
+#include "min_phase.hpp"
+#include "moving_average.hpp"
+#include "parallel_bank.hpp"
+#include "partitioned_convolver.hpp"
+#include "perf_counters.hpp"
+#include "recorder.hpp"
+#include "rt_memory.hpp"
+#include "tolerance_design.hpp"
+
+#include <semaphore.h>
+
 // This is an generated header file. You may change the namespace, but
 // make sure to do the same in implementation (.cpp) file
 namespace fir_window
@@ -23,22 +41,101 @@ namespace fir_window
 
 constexpr std::string_view MODULE_NAME = "fir-window";
 
-enum window_t : int64_t
+// number of "Band" output channels available in filter bank mode
+constexpr size_t MAX_BANDS = 8;
+
+// analytic signal outputs follow the band outputs; the in-phase
+// component goes to output(0)
+constexpr size_t QUADRATURE_OUTPUT = MAX_BANDS + 1;
+constexpr size_t AMPLITUDE_OUTPUT = MAX_BANDS + 2;
+constexpr size_t PHASE_OUTPUT = MAX_BANDS + 3;
+constexpr size_t NUM_OUTPUTS = MAX_BANDS + 4;
+
+// number of telemetry records the RT thread can queue ahead of the Panel
+constexpr size_t TELEMETRY_FIFO_RECORDS = 1024;
+
+// One record is sent from the real-time thread to the Panel every
+// "Telemetry Decimation" periods. Samples are the ones seen on the last
+// period of the window, kernel timing covers every period of the window.
+struct telemetry_t
 {
-  RECT = 0,
-  TRI,
-  HAMM,
-  HANN,
-  CHEBY,
-  KAISER
+  int64_t time;  // ns, RT clock
+  double input;
+  double output;
+  double kernel_mean_ns;
+  int64_t kernel_max_ns;
+  uint64_t dropped;  // records the fifo could not accept so far
+  // hardware counts per period over the window, with "Perf Counters" on;
+  // bit e of counters_valid is set if event e could be counted
+  uint32_t counters_valid;
+  double counters[PerfCounters::NUM_EVENTS];
 };
 
-enum filter_t : int64_t
+// how often the designer thread wakes to free retired sets when no design
+// is asked for
+constexpr long DESIGNER_POLL_NS = 100000000;
+
+// capacity of the recorder ring between the RT thread and the disk writer
+constexpr size_t RECORDER_RING_FRAMES = size_t {1} << 16;
+
+// One recorder frame per period. output is output(0), bands are the
+// filter bank outputs (zero in single filter mode). period counts the
+// periods run since the module was initialized, paused ones included, so
+// gaps show where frames were dropped.
+struct recording_frame_t
+{
+  uint64_t period;
+  double input;
+  double output;
+  double bands[MAX_BANDS];
+};
+
+// Header of a recording file. It is written once at the start of the
+// file and padded to Recorder::HEADER_BYTES; frames follow. Whenever the
+// filter is retuned during a recording, the new filter's header is
+// written into the frame stream, zero padded to description_frames
+// frames, ahead of the first frame it produced. Its magic takes the place
+// of a period, which never reaches that value.
+struct recording_header_t
+{
+  char magic[8];  // "FIRWREC"
+  uint32_t version;
+  uint32_t frame_bytes;
+  double period;  // s
+  int64_t window_shape;
+  int64_t filter_type;
+  int64_t filter_mode;
+  int64_t phase_response;
+  int64_t num_taps;
+  double lambda1;
+  double lambda2;
+  double Kalpha;
+  double Calpha;
+  uint64_t num_band_edges;
+  double band_edges[MAX_BANDS + 1];
+  int64_t design_method;
+  double transition_width;
+  double stopband_weight;
+  int64_t average_stages;
+  uint64_t description_frames;
+};
+
+// frames a header takes when it is written into the frame stream
+constexpr size_t DESCRIPTION_FRAMES =
+    (sizeof(recording_header_t) + sizeof(recording_frame_t) - 1)
+    / sizeof(recording_frame_t);
+
+enum filter_mode_t : int64_t
 {
-  LOWPASS = 0,
-  HIGHPASS,
-  BANDPASS,
-  BANDSTOP
+  SINGLE = 0,
+  FILTER_BANK,
+  ANALYTIC
+};
+
+enum engine_t : int64_t
+{
+  DIRECT = 0,
+  HYBRID_FFT
 };
 
 enum PARAMETER : Widgets::Variable::Id
@@ -50,7 +147,41 @@ enum PARAMETER : Widgets::Variable::Id
   FREQUENCY_1,
   FREQUENCY_2,
   CHEBYSHEV_ATTENUATION,
-  KAISER_ALPHA_ATTENUATION
+  KAISER_ALPHA_ATTENUATION,
+  FILTER_MODE,
+  BAND_EDGES,
+  TELEMETRY_DECIMATION,
+  RECORDER_DIRECT_IO,
+  PHASE_RESPONSE,
+  GROUP_DELAY_SAMPLES,
+  GROUP_DELAY_MS,
+  ENGINE,
+  HEAD_TAPS,
+  TAIL_DEADLINE_MISSES,
+  FEED_WHILE_PAUSED,
+  MODULATION_INTERVAL,
+  MODULATION_MIN,
+  MODULATION_MAX,
+  MODULATED_CUTOFF,
+  UNLOCKED_BUFFERS,
+  HUGE_PAGE_BUFFERS,
+  HELPER_CPUS,
+  HELPER_DEADLINE_MISSES,
+  DESIGN_METHOD,
+  TRANSITION_WIDTH,
+  STOPBAND_WEIGHT,
+  TAPS_FROM_SPEC,
+  PASSBAND_RIPPLE,
+  STOPBAND_ATTENUATION,
+  MAX_TAPS,
+  DESIGNED_TAPS,
+  SPEC_MET,
+  PERF_COUNTERS,
+  AVERAGE_STAGES,
+  SHARED_BLOCKS,
+  SHARED_USERS,
+  MODULATION_ERROR,
+  DESIGN_FAILURES
 };
 
 inline std::vector<Widgets::Variable::Info> get_default_vars()
@@ -97,21 +228,241 @@ inline std::vector<Widgets::Variable::Info> get_default_vars()
        "Kaiser Alpha",
        "Attenuation Parameter for Kaiser Window",
        Widgets::Variable::DOUBLE_PARAMETER,
-       1.5}};
+       1.5},
+      {PARAMETER::FILTER_MODE,
+       "Filter Mode",
+       "Single filter, a bank of bandpass filters over one delay line, or "
+       "the analytic signal of the Frequency 1-2 band",
+       Widgets::Variable::INT_PARAMETER,
+       fir_window::SINGLE},
+      {PARAMETER::BAND_EDGES,
+       "Band Edges",
+       "Ascending band edges as fractions of Pi, separated by spaces or "
+       "commas. K+1 edges define K bandpass filters (filter bank mode only)",
+       Widgets::Variable::COMMENT,
+       std::string("0.002 0.004 0.008 0.013 0.03 0.1")},
+      {PARAMETER::TELEMETRY_DECIMATION,
+       "Telemetry Decimation",
+       "Send input/output samples and kernel timing to the panel every N "
+       "periods (0 disables telemetry)",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {100}},
+      {PARAMETER::RECORDER_DIRECT_IO,
+       "Recorder Direct I/O",
+       "1 to bypass the page cache (O_DIRECT) when recording to disk",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {0}},
+      {PARAMETER::PHASE_RESPONSE,
+       "Phase Response",
+       "Linear phase, or the minimum-phase filter with the same magnitude "
+       "response",
+       Widgets::Variable::INT_PARAMETER,
+       fir_window::LINEAR_PHASE},
+      {PARAMETER::GROUP_DELAY_SAMPLES,
+       "Group Delay (samples)",
+       "Group delay of the filter at the centre of its passband",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::GROUP_DELAY_MS,
+       "Group Delay (ms)",
+       "Group delay of the filter at the centre of its passband",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::ENGINE,
+       "Convolution Engine",
+       "Direct convolution, or a direct head with an FFT tail computed on a "
+       "helper thread (single filter mode only)",
+       Widgets::Variable::INT_PARAMETER,
+       fir_window::DIRECT},
+      {PARAMETER::HEAD_TAPS,
+       "Head Taps",
+       "Taps convolved directly in the real-time thread by the hybrid "
+       "engine, rounded up to twice a power of two",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {256}},
+      {PARAMETER::TAIL_DEADLINE_MISSES,
+       "Tail Deadline Misses",
+       "Blocks whose FFT tail was not ready in time and was dropped",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::FEED_WHILE_PAUSED,
+       "Feed While Paused",
+       "1 to keep feeding the input history while paused so that resuming "
+       "needs no settling time",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {1}},
+      {PARAMETER::MODULATION_INTERVAL,
+       "Modulation Interval",
+       "Regenerate the coefficients from the Cutoff Modulation input every "
+       "N samples (0 disables modulation, direct single filter only)",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {0}},
+      {PARAMETER::MODULATION_MIN,
+       "Modulation Min",
+       "Lowest cutoff (fraction of Pi) the modulation input can select",
+       Widgets::Variable::DOUBLE_PARAMETER,
+       0.05},
+      {PARAMETER::MODULATION_MAX,
+       "Modulation Max",
+       "Highest cutoff (fraction of Pi) the modulation input can select",
+       Widgets::Variable::DOUBLE_PARAMETER,
+       0.4},
+      {PARAMETER::MODULATED_CUTOFF,
+       "Modulated Cutoff",
+       "Cutoff (or band centre) currently applied by modulation",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::UNLOCKED_BUFFERS,
+       "Unlocked Buffers",
+       "Real-time buffers that could not be locked in memory (raise "
+       "RLIMIT_MEMLOCK if this is not 0)",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::HUGE_PAGE_BUFFERS,
+       "Huge Page Buffers",
+       "Real-time buffers backed by huge pages",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::HELPER_CPUS,
+       "Helper CPUs",
+       "CPUs for spinning helper threads that share the filter bank and "
+       "analytic signal work, separated by spaces or commas (empty: none)",
+       Widgets::Variable::COMMENT,
+       std::string("")},
+      {PARAMETER::HELPER_DEADLINE_MISSES,
+       "Helper Deadline Misses",
+       "Periods in which a helper thread was late and its share was "
+       "computed in the real-time thread",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::DESIGN_METHOD,
+       "Design Method",
+       "Window method, equiripple (Parks-McClellan) or least squares",
+       Widgets::Variable::INT_PARAMETER,
+       fir_window::WINDOW_METHOD},
+      {PARAMETER::TRANSITION_WIDTH,
+       "Transition Width",
+       "Width of the transition band centred on each cutoff, as a fraction "
+       "of Pi (equiripple, least squares and Taps From Spec)",
+       Widgets::Variable::DOUBLE_PARAMETER,
+       0.05},
+      {PARAMETER::STOPBAND_WEIGHT,
+       "Stopband Weight",
+       "Weight of the stopband error relative to the passband error "
+       "(equiripple and least squares only)",
+       Widgets::Variable::DOUBLE_PARAMETER,
+       1.0},
+      {PARAMETER::TAPS_FROM_SPEC,
+       "Taps From Spec",
+       "1 to ignore # Taps and use the fewest taps that meet Passband "
+       "Ripple and Stopband Attenuation",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {0}},
+      {PARAMETER::PASSBAND_RIPPLE,
+       "Passband Ripple (dB)",
+       "Largest peak to peak passband ripple allowed (Taps From Spec)",
+       Widgets::Variable::DOUBLE_PARAMETER,
+       0.1},
+      {PARAMETER::STOPBAND_ATTENUATION,
+       "Stopband Attenuation (dB)",
+       "Smallest stopband attenuation allowed (Taps From Spec)",
+       Widgets::Variable::DOUBLE_PARAMETER,
+       60.0},
+      {PARAMETER::MAX_TAPS,
+       "Max Taps",
+       "Longest filter Taps From Spec may choose",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {4001}},
+      {PARAMETER::DESIGNED_TAPS,
+       "Designed Taps",
+       "Number of taps of the filter in use",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::SPEC_MET,
+       "Spec Met",
+       "1 if the filter meets the ripple and attenuation spec (Taps From "
+       "Spec), 0 if Max Taps was not enough",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::PERF_COUNTERS,
+       "Perf Counters",
+       "1 to count cycles, instructions, cache and branch misses of the "
+       "kernel with hardware counters and add them to the telemetry",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {0}},
+      {PARAMETER::AVERAGE_STAGES,
+       "Moving Average Stages",
+       "Number of cascaded # Taps point moving averages (CIC stages) of "
+       "the Moving Average filter type, 1 to 8",
+       Widgets::Variable::INT_PARAMETER,
+       int64_t {1}},
+      {PARAMETER::SHARED_BLOCKS,
+       "Shared Coefficient Blocks",
+       "Distinct coefficient sets held by all fir-window instances",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::SHARED_USERS,
+       "Shared Coefficient Users",
+       "Filters using those coefficient sets; more users than blocks means "
+       "identical designs are stored once",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::MODULATION_ERROR,
+       "Modulation Error",
+       "Largest error of a tap interpolated from the cutoff table; 1e-5 "
+       "unless the filter is too long for the table",
+       Widgets::Variable::STATE,
+       0.0},
+      {PARAMETER::DESIGN_FAILURES,
+       "Design Failures",
+       "Parameter changes that could not be designed or ran out of memory; "
+       "the previous filter kept running",
+       Widgets::Variable::STATE,
+       0.0}};
 }
 
 inline std::vector<IO::channel_t> get_default_channels()
 {
-  return {{
-              "Input",
-              "Input to Filter",
-              IO::INPUT,
-          },
-          {
-              "Output",
-              "Output of Filter",
-              IO::OUTPUT,
-          }};
+  std::vector<IO::channel_t> channels = {{
+                                             "Input",
+                                             "Input to Filter",
+                                             IO::INPUT,
+                                         },
+                                         {
+                                             "Cutoff Modulation",
+                                             "Cutoff (lowpass/highpass) or "
+                                             "band centre (bandpass/bandstop) "
+                                             "as a fraction of Pi",
+                                             IO::INPUT,
+                                         },
+                                         {
+                                             "Output",
+                                             "Output of Filter",
+                                             IO::OUTPUT,
+                                         }};
+  for (size_t band = 1; band <= MAX_BANDS; band++) {
+    channels.push_back({
+        "Band " + std::to_string(band),
+        "Output of filter bank band " + std::to_string(band),
+        IO::OUTPUT,
+    });
+  }
+  channels.push_back({
+      "Quadrature",
+      "Hilbert transform of the bandpassed input (analytic signal mode)",
+      IO::OUTPUT,
+  });
+  channels.push_back({
+      "Amplitude",
+      "Instantaneous amplitude (analytic signal mode)",
+      IO::OUTPUT,
+  });
+  channels.push_back({
+      "Phase",
+      "Instantaneous phase in radians (analytic signal mode)",
+      IO::OUTPUT,
+  });
+  return channels;
 }
 
 class Panel : public Widgets::Panel
@@ -125,6 +476,22 @@ private:
   // FIRwindow functions
   QComboBox* windowShape;
   QComboBox* filterType;
+  QComboBox* filterMode;
+  QComboBox* phaseResponse;
+  QComboBox* designMethod;
+  QComboBox* convolutionEngine;
+
+  // live readout of the telemetry stream published by the component
+  QTimer* telemetryTimer;
+  QLabel* telemetryInput;
+  QLabel* telemetryOutput;
+  QLabel* telemetryKernel;
+  QLabel* telemetryDropped;
+  std::array<QLabel*, PerfCounters::NUM_EVENTS> telemetryCounters {};
+
+  // built-in recorder of the filter input and outputs
+  QPushButton* recordButton;
+  QLabel* recorderStatus;
 
   // Saving FIR filter data to file without Data Recorder
   bool OpenFile(QString);
@@ -136,46 +503,234 @@ private slots:
   void saveFIRData();  // write filter parameters to a file
   void updateWindow(int);
   void updateFilterType(int);
+  void updateFilterMode(int);
+  void updatePhaseResponse(int);
+  void updateDesignMethod(int);
+  void updateEngine(int);
+  void readTelemetry();
+  void toggleRecording(bool);
+  void refreshRecorder();
 
   // Any functions and data related to the GUI are to be placed here
 };
 
+// longest Band Edges or Helper CPUs text a design reads, in bytes
+constexpr size_t LIST_PARAMETER_BYTES = 256;
+
+// The parameters a design depends on, exactly as entered. execute() copies
+// them at INIT and MODIFY, when RTXI cannot be changing them, and hands the
+// copy to the designer thread, which never reads a parameter itself.
+struct design_settings_t
+{
+  int64_t window_shape;
+  int64_t filter_type;
+  int64_t num_taps;
+  double lambda1;
+  double lambda2;
+  double Kalpha;
+  double Calpha;
+  int64_t filter_mode;
+  int64_t phase_response;
+  int64_t design_method;
+  double transition_width;
+  double stopband_weight;
+  int64_t taps_from_spec;
+  double passband_ripple;
+  double stopband_attenuation;
+  int64_t max_taps;
+  int64_t average_stages;
+  int64_t engine;
+  int64_t head_taps;
+  int64_t modulation_interval;
+  double modulation_min;
+  double modulation_max;
+  int64_t perf_counters;  // and telemetry on to show them
+  int64_t rt_tid;  // the thread execute() runs on
+  std::array<char, LIST_PARAMETER_BYTES> band_edges;  // NUL terminated
+  std::array<char, LIST_PARAMETER_BYTES> helper_cpus;
+};
+
+// Everything execute() runs for one set of parameters. Sets are designed
+// on the Component's designer thread and handed to the real-time thread
+// whole, so execute() never designs, allocates, frees or starts a thread.
+struct filter_set_t
+{
+  // the parameters the set was designed for, with num_taps and the shape
+  // parameters as chosen by fitToSpec()
+  window_t window_shape {};
+  filter_t filter_type {};
+  int64_t num_taps = 1;
+  double lambda1 = 0;  // cutoff frequencies
+  double lambda2 = 0;
+  double Kalpha = 0;  // Kaiser window sidelobe attenuation parameter
+  double Calpha = 0;  // Chebyshev window sidelobe attenuation parameter
+  filter_mode_t filter_mode {};
+  phase_t phase_response {};
+  method_t design_method {};
+  double transition_width = 0;
+  double stopband_weight = 1;
+  bool taps_from_spec = false;  // num_taps etc. come from fitToSpec
+  Tolerance tolerance;
+  int64_t max_taps = 1;
+  int64_t average_stages = 1;
+  engine_t engine {};
+  int64_t head_taps = 2;
+  int64_t modulation_interval = 0;
+  double modulation_min = 0;
+  double modulation_max = 0;
+  std::vector<double> band_edges;
+  std::vector<int> helper_cpus;
+
+  // h[0] applies to the newest sample; null for the moving average
+  SharedCoefficients coefficients;
+  FirFilter direct_filter;
+
+  // single filter mode, MOVING_AVERAGE filter type
+  MovingAverage moving_average;
+
+  // single filter mode with the hybrid engine
+  PartitionedConvolver convolver;
+
+  // cutoff modulation: coefficients rebuilt from a table in execute()
+  CutoffTable cutoff_table;
+  rt_vector<double> modulated;
+
+  // filter bank mode: one bandpass design per pair of adjacent edges.
+  // Analytic signal mode reuses the bank with two rows, the bandpass
+  // filter and its Hilbert partner.
+  FilterBank bank;
+  // optional helpers that split the bank's taps across dedicated cores
+  ParallelBank parallel_bank;
+
+  // hardware counters of the real-time thread, opened by the designer
+  PerfCounters counters;
+
+  // recorded ahead of the set's first frame when it replaces another
+  std::array<recording_frame_t, DESCRIPTION_FRAMES> description {};
+
+  // states execute() reports when it switches to the set
+  double group_delay = 0;  // samples
+  bool spec_met = false;
+  double modulation_error = 0;
+  RtMemoryStats memory;
+  CoefficientRegistry::Stats shared {};
+
+  // link in the list of sets execute() has let go of
+  filter_set_t* next_retired = nullptr;
+};
+
 class Component : public Widgets::Component
 {
 public:
   explicit Component(Widgets::Plugin* hplugin);
+  ~Component() override;
+  Component(const Component&) = delete;
+  Component& operator=(const Component&) = delete;
   void execute() override;
+  RT::OS::Fifo* getTelemetryFifo() { return telemetry_fifo.get(); }
+  Recorder& getRecorder() { return recorder; }
+  // the filter that is running, or about to after a parameter change
+  recording_header_t describe();
 
 private:
-  boost::circular_buffer<double> signalin;
-  double* convolution;
   double out;
   double dt;
   int n;
 
-  void initParameters();
-  void bookkeep();
-  void makeFilter();
+  // real-time thread
+  void loadParameters();
+  void readSettings(design_settings_t& settings);
+  void requestDesign();
+  void adoptFilterSet();
+  void feedHistory(filter_set_t& set, double input);
+  void modulateCutoff(filter_set_t& set, double control);
+  void publishTelemetry(filter_set_t& set,
+                        double input,
+                        double output,
+                        int64_t kernel_ns);
 
-  //	double* h2;
-  double* h3;  // filter coefficients
-  window_t window_shape;
-  filter_t filter_type;
-  int64_t num_taps;
-  double lambda1;  // cutoff frequencies
-  double lambda2;
-  double Kalpha;  // Kaiser window sidelobe attenuation parameter
-  double Calpha;  // Chebyshev window sidelobe attenuation parameter
+  // designer thread
+  void designerLoop();
+  filter_set_t* releaseRetired(filter_set_t* adopted_set);
+  std::unique_ptr<filter_set_t> buildFilterSet(
+      const design_settings_t& settings);
+  void loadSettings(filter_set_t& set, const design_settings_t& settings);
+  void fitToSpec(filter_set_t& set);
+  DesignSpec designSpec(const filter_set_t& set,
+                        double low,
+                        double high,
+                        filter_t type) const;
+  void makeFilter(filter_set_t& set);
+  void makeFilterBank(filter_set_t& set);
+  void makeAnalyticFilter(filter_set_t& set);
+  void attachBank(filter_set_t& set);
+  void startHelpers(filter_set_t& set);
+  void openCounters(filter_set_t& set, const design_settings_t& settings);
+  void makeCutoffTable(filter_set_t& set);
+  double passbandCentre(double low, double high, filter_t type) const;
+  void reportGroupDelay(filter_set_t& set);
+  void reportMemory(filter_set_t& set);
+  recording_header_t describe(const filter_set_t& set) const;
 
-private:
-  GenericWindow* disc_window;
-  FirIdealFilter* filter_design;
+  // Hand-over between the threads. execute() asks for a design by passing
+  // its settings through a triple buffer: it fills the back slot and swaps
+  // it with the middle one, marked SETTINGS_NEW, and the designer swaps
+  // the middle one for its front slot when it sees the mark. The designer
+  // leaves the finished set in pending, execute() swaps it in for active
+  // and pushes the old one onto retired, and the designer frees retired
+  // sets.
+  static constexpr unsigned SETTINGS_NEW = 4;
+  std::array<design_settings_t, 3> settings_slots {};
+  unsigned settings_back = 0;  // real-time thread only
+  std::atomic<unsigned> settings_middle {1};
+  unsigned settings_front = 2;  // designer thread only
+  filter_set_t* active = nullptr;  // real-time thread only
+  std::atomic<filter_set_t*> pending {nullptr};
+  std::atomic<filter_set_t*> retired {nullptr};
+  // the set execute() switched to last, until the designer starts its
+  // helpers
+  std::atomic<filter_set_t*> adopted {nullptr};
+  // designs abandoned as impossible or for lack of memory, and the count
+  // execute() showed
+  std::atomic<uint64_t> design_failures {0};
+  uint64_t reported_failures = 0;
+  sem_t design_request;
+  std::atomic<bool> stopping {false};
+  std::thread designer;
+  std::mutex header_mutex;
+  recording_header_t header {};  // of the newest set, under header_mutex
+
+  // designs come from here, so reloading a workspace redoes no design work;
+  // designer thread only
+  CoefficientCache cache {CoefficientCache::defaultDirectory()};
+
+  bool feed_while_paused = false;
+  int64_t modulation_count = 0;
+  std::array<double, MAX_BANDS> band_out {};
+
+  // telemetry: written only from execute(), never blocks
+  std::unique_ptr<RT::OS::Fifo> telemetry_fifo;
+  int64_t telemetry_decimation = 0;
+  int64_t telemetry_count = 0;
+  int64_t kernel_ns_sum = 0;
+  int64_t kernel_ns_max = 0;
+  uint64_t telemetry_dropped = 0;
+  // captured at INIT so the designer can open counters for this thread
+  pid_t rt_tid = 0;
+
+  Recorder recorder;
+  recording_frame_t frame {};
+  uint64_t periods = 0;
 };
 
 class Plugin : public Widgets::Plugin
 {
 public:
   explicit Plugin(Event::Manager* ev_manager);
+  RT::OS::Fifo* getTelemetryFifo();
+  bool startRecording(const std::string& path);
+  void stopRecording();
+  const Recorder* getRecorder();
 };
 
 }  // namespace fir_window